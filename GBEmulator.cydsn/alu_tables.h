@@ -0,0 +1,32 @@
+/*
+Lookup tables for the ALU flags, used by instruction_set.h when ALU_LOOKUP_TABLES_ON is set
+The tables are const so they stay in flash; alu_tables.c is generated by host/gen_alu_tables.c
+from the arithmetic versions in instruction_set.h (make -C host alu_tables)
+*/
+#ifndef ALU_TABLES_H
+#define ALU_TABLES_H
+#include "stdint.h"
+
+// Flag bits in register F
+#define FLAG_Z 0x80
+#define FLAG_N 0x40
+#define FLAG_H 0x20
+#define FLAG_C 0x10
+#define FLAG_UNUSED 0x0F    // low nibble, left as it is by every instruction
+
+#define DAA_TABLE_SIZE 2048
+
+// Result of DAA, indexed by N H C (bits 10-8) and A (bits 7-0)
+// The high byte is the new A, the low byte the new Z and C flags
+extern const uint16_t daa_table[DAA_TABLE_SIZE];
+// Z and H after INC, indexed by the result
+extern const uint8_t inc_flag_table[256];
+// Z, N and H after DEC, indexed by the result
+extern const uint8_t dec_flag_table[256];
+// Z, indexed by a result
+extern const uint8_t zero_flag_table[256];
+
+static inline uint16_t daa_table_index(uint8_t a, uint8_t f){
+    return ((f & (FLAG_N | FLAG_H | FLAG_C)) << 4) | a;
+}
+#endif
@@ -0,0 +1,431 @@
+#include "apu.h"
+#include <project.h>
+#include "emumode.h"
+#include "string.h"
+
+#define SEQUENCER_PERIOD 8192          // T-cycles per frame sequencer step (512 Hz)
+#define APU_GAIN 32                    // 4 channels * level 15 * volume 8 * 2 sides * 32 fits in an int16
+// Output samples per T-cycle, as a 32 bit fraction
+#define CYCLES_TO_SAMPLES ((uint32_t) (((uint64_t) APU_SAMPLE_RATE << 32) / APU_CLOCK_HZ))
+// Above these periods (T-cycles per step) a square or wave tone is past the output Nyquist frequency,
+// so it is played as its average level instead
+#define MIN_SQUARE_PERIOD 48
+#define MIN_WAVE_PERIOD 12
+// The noise lfsr is not clocked faster than about once per output sample
+#define MIN_NOISE_PERIOD (APU_CLOCK_HZ / APU_SAMPLE_RATE)
+
+// Registers, as offsets from SOUND_START; each channel has 5 (NRx0-NRx4) starting at channel * 5
+#define NR10 0x00
+#define NR30 0x0A
+#define NR32 0x0C
+#define NR43 0x12
+#define NR50 0x14
+#define NR51 0x15
+#define NR52 0x16
+#define WAVE_RAM (WAVE_RAM_START - SOUND_START)
+
+enum { SQUARE_1, SQUARE_2, WAVE, NOISE };
+
+// Which of the 8 duty steps are high, for each duty (12.5%, 25%, 50%, 75%)
+static const uint8_t duty_patterns[4] = {0x01, 0x81, 0x87, 0x7E};
+static const uint8_t duty_high_steps[4] = {1, 2, 4, 6};
+static const uint8_t noise_divisors[8] = {8, 16, 32, 48, 64, 80, 96, 112};
+static const uint8_t wave_volume_shifts[4] = {4, 0, 1, 2};    // mute, 100%, 50%, 25%
+
+// true if time a comes before time b (T-cycle times wrap around)
+static inline bool before(uint32_t a, uint32_t b){
+    return (int32_t) (a - b) < 0;
+}
+
+static inline uint8_t* channel_regs(Apu* apu, int channel){
+    return &apu->regs[channel * 5];
+}
+
+static bool dac_on(Apu* apu, int channel){
+    if (channel == WAVE) return apu->regs[NR30] & 0x80;
+    return channel_regs(apu, channel)[2] & 0xF8;
+}
+
+// Adds a change of the output at time t as a band-limited step
+static void add_delta(Apu* apu, uint32_t t, int32_t delta){
+    uint64_t pos = apu->buffer_frac + (uint64_t) (t - apu->buffer_time) * CYCLES_TO_SAMPLES;
+    int32_t* out = &apu->deltas[pos >> 32];
+    const int16_t* kernel = blep_table[(uint32_t) pos >> (32 - BLEP_PHASE_BITS)];
+    int i;
+    for (i = 0; i < BLEP_TAPS; i++){
+        out[i] += delta * kernel[i];
+    }
+}
+
+static void set_level(Apu* apu, int channel, uint32_t t, uint8_t level){
+    ApuChannel* ch = &apu->channels[channel];
+    int32_t output = level * apu->channel_gain[channel];
+    ch->level = level;
+    if (output != ch->output){
+        if (apu->sink != APU_SINK_NULL) add_delta(apu, t, output - ch->output);
+        ch->output = output;
+    }
+}
+
+// What the channel puts into its DAC right now
+static uint8_t channel_level(Apu* apu, int channel){
+    ApuChannel* ch = &apu->channels[channel];
+    if (!ch->on) return 0;
+    switch (channel){
+        case SQUARE_1:
+        case SQUARE_2: {
+            uint8_t duty = channel_regs(apu, channel)[1] >> 6;
+            if (ch->period < MIN_SQUARE_PERIOD) return ch->volume * duty_high_steps[duty] / 8;
+            return ((duty_patterns[duty] >> ch->position) & 1) ? ch->volume : 0;
+        }
+        case WAVE: {
+            uint8_t shift = wave_volume_shifts[(apu->regs[NR32] >> 5) & 0x3];
+            if (ch->period < MIN_WAVE_PERIOD){
+                int sum = 0;
+                int i;
+                for (i = 0; i < 16; i++){
+                    sum += (apu->regs[WAVE_RAM + i] >> 4) + (apu->regs[WAVE_RAM + i] & 0xF);
+                }
+                return (sum / 32) >> shift;
+            }
+            uint8_t byte = apu->regs[WAVE_RAM + ch->position / 2];
+            return ((ch->position & 1) ? byte & 0xF : byte >> 4) >> shift;
+        }
+        default:
+            return (ch->lfsr & 1) ? 0 : ch->volume;
+    }
+}
+
+static inline void refresh_level(Apu* apu, int channel, uint32_t t){
+    set_level(apu, channel, t, channel_level(apu, channel));
+}
+
+static void update_period(Apu* apu, int channel){
+    ApuChannel* ch = &apu->channels[channel];
+    if (channel == NOISE){
+        uint8_t nr43 = apu->regs[NR43];
+        uint32_t period = (uint32_t) noise_divisors[nr43 & 0x7] << (nr43 >> 4);
+        ch->period = period < MIN_NOISE_PERIOD ? MIN_NOISE_PERIOD : period;
+    } else {
+        ch->period = (2048 - ch->freq) * (channel == WAVE ? 2 : 4);
+    }
+}
+
+static void update_gains(Apu* apu, uint32_t t){
+    int left = ((apu->regs[NR50] >> 4) & 0x7) + 1;
+    int right = (apu->regs[NR50] & 0x7) + 1;
+    int channel;
+    for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+        bool to_left = (apu->regs[NR51] >> (channel + 4)) & 1;
+        bool to_right = (apu->regs[NR51] >> channel) & 1;
+        apu->channel_gain[channel] = (to_left * left + to_right * right) * APU_GAIN;
+        set_level(apu, channel, t, apu->channels[channel].level);
+    }
+}
+
+// Square 1's next sweep frequency; turns the channel off when it overflows
+static uint16_t sweep_freq(Apu* apu){
+    uint16_t delta = apu->shadow_freq >> (apu->regs[NR10] & 0x7);
+    uint16_t freq = (apu->regs[NR10] & 0x08) ? apu->shadow_freq - delta : apu->shadow_freq + delta;
+    if (freq > 2047) apu->channels[SQUARE_1].on = false;
+    return freq;
+}
+
+static void trigger(Apu* apu, int channel, uint32_t t){
+    ApuChannel* ch = &apu->channels[channel];
+    uint8_t* regs = channel_regs(apu, channel);
+    ch->on = dac_on(apu, channel);
+    if (ch->length == 0) ch->length = channel == WAVE ? 256 : 64;
+    update_period(apu, channel);
+    ch->next_step = t + ch->period;
+    if (channel == WAVE){
+        ch->position = 0;
+    } else {
+        ch->volume = regs[2] >> 4;
+        ch->envelope_timer = regs[2] & 0x7;
+    }
+    if (channel == NOISE) ch->lfsr = 0x7FFF;
+    if (channel == SQUARE_1){
+        uint8_t sweep_period = (apu->regs[NR10] >> 4) & 0x7;
+        apu->shadow_freq = ch->freq;
+        apu->sweep_timer = sweep_period ? sweep_period : 8;
+        apu->sweep_enabled = sweep_period || (apu->regs[NR10] & 0x7);
+        if (apu->regs[NR10] & 0x7) sweep_freq(apu);
+    }
+}
+
+static void power_off(Apu* apu, uint32_t t){
+    memset(apu->regs, 0, NR52);
+    int channel;
+    for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+        apu->channels[channel].on = false;
+        apu->channels[channel].length = 0;
+    }
+    update_gains(apu, t);
+}
+
+// Replays one logged write at time t
+static void apply_write(Apu* apu, uint8_t reg, uint8_t data, uint32_t t){
+    apu->regs[reg] = data;
+    if (reg >= WAVE_RAM){
+        refresh_level(apu, WAVE, t);
+        return;
+    }
+    if (reg == NR50 || reg == NR51){
+        update_gains(apu, t);
+        return;
+    }
+    if (reg == NR52){
+        if (!(data & 0x80)) power_off(apu, t);
+        else apu->sequencer_step = 0;
+        return;
+    }
+
+    int channel = reg / 5;
+    ApuChannel* ch = &apu->channels[channel];
+    switch (reg % 5){
+        case 1:     // length load
+            ch->length = channel == WAVE ? 256 - data : 64 - (data & 0x3F);
+            break;
+        case 3:     // frequency low, or the noise clock
+            ch->freq = (ch->freq & 0x700) | data;
+            update_period(apu, channel);
+            break;
+        case 4:     // frequency high and trigger
+            ch->freq = (ch->freq & 0xFF) | ((data & 0x7) << 8);
+            update_period(apu, channel);
+            if (data & 0x80) trigger(apu, channel, t);
+            break;
+        default:
+            break;
+    }
+    if (!dac_on(apu, channel)) ch->on = false;
+    refresh_level(apu, channel, t);
+}
+
+// One 512 Hz frame sequencer step: lengths at 256 Hz, sweep at 128 Hz, envelopes at 64 Hz
+static void step_sequencer(Apu* apu, uint32_t t){
+    uint8_t step = apu->sequencer_step;
+    int channel;
+    if ((step & 1) == 0){
+        for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+            ApuChannel* ch = &apu->channels[channel];
+            if ((channel_regs(apu, channel)[4] & 0x40) && ch->length > 0){
+                ch->length--;
+                if (ch->length == 0) ch->on = false;
+            }
+        }
+    }
+    if ((step == 2 || step == 6) && --apu->sweep_timer == 0){
+        uint8_t sweep_period = (apu->regs[NR10] >> 4) & 0x7;
+        apu->sweep_timer = sweep_period ? sweep_period : 8;
+        if (apu->sweep_enabled && sweep_period){
+            uint16_t freq = sweep_freq(apu);
+            if (freq <= 2047 && (apu->regs[NR10] & 0x7)){
+                apu->shadow_freq = freq;
+                apu->channels[SQUARE_1].freq = freq;
+                update_period(apu, SQUARE_1);
+                sweep_freq(apu);
+            }
+        }
+    }
+    if (step == 7){
+        for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+            if (channel == WAVE) continue;
+            ApuChannel* ch = &apu->channels[channel];
+            uint8_t envelope = channel_regs(apu, channel)[2];
+            uint8_t period = envelope & 0x7;
+            if (period == 0 || --ch->envelope_timer != 0) continue;
+            ch->envelope_timer = period;
+            if ((envelope & 0x08) && ch->volume < 15) ch->volume++;
+            if (!(envelope & 0x08) && ch->volume > 0) ch->volume--;
+        }
+    }
+    apu->sequencer_step = (step + 1) & 0x7;
+    for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+        refresh_level(apu, channel, t);
+    }
+}
+
+// Steps every channel's waveform up to time end, adding each change to the output
+static void run_channels(Apu* apu, uint32_t end){
+    static const uint32_t min_periods[APU_CHANNEL_COUNT] = {MIN_SQUARE_PERIOD, MIN_SQUARE_PERIOD, MIN_WAVE_PERIOD, 0};
+    int channel;
+    for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+        ApuChannel* ch = &apu->channels[channel];
+        if (!ch->on || apu->sink == APU_SINK_NULL || ch->period < min_periods[channel]){
+            // nothing changes until the next event
+            ch->next_step = end;
+            continue;
+        }
+        while (before(ch->next_step, end)){
+            if (channel == NOISE){
+                uint16_t bit = (ch->lfsr ^ (ch->lfsr >> 1)) & 1;
+                ch->lfsr = (ch->lfsr >> 1) | (bit << 14);
+                if (apu->regs[NR43] & 0x08) ch->lfsr = (ch->lfsr & ~0x40) | (bit << 6);
+            } else {
+                ch->position = (ch->position + 1) & (channel == WAVE ? 31 : 7);
+            }
+            refresh_level(apu, channel, ch->next_step);
+            ch->next_step += ch->period;
+        }
+    }
+}
+
+// Replays the logged writes and frame sequencer steps up to time end
+static void replay(Apu* apu, uint32_t end, int* next_write){
+    Memory* mem = apu->mem;
+    for (;;){
+        uint32_t t = end;
+        bool is_write = false;
+        if (*next_write < mem->sound_write_count){
+            uint32_t write_time = mem->sound_writes[*next_write].time;
+            if (before(write_time, apu->time)) write_time = apu->time;
+            if (!before(end, write_time)){
+                t = write_time;
+                is_write = true;
+            }
+        }
+        bool is_step = !before(t, apu->next_sequencer);
+        if (is_step) t = apu->next_sequencer;
+
+        run_channels(apu, t);
+        apu->time = t;
+        if (is_step){
+            step_sequencer(apu, t);
+            apu->next_sequencer += SEQUENCER_PERIOD;
+        } else if (is_write){
+            SoundWrite* write = &mem->sound_writes[(*next_write)++];
+            apply_write(apu, write->reg, write->data, t);
+        } else {
+            return;
+        }
+    }
+}
+
+#if APU_VDAC_OUTPUT
+// Two halves the DMA plays back to back, one burst per Timer_Audio tick; samples are written into
+// the half that isn't playing, and dropped once they catch up with the DMA
+#define VDAC_BUFFER_SAMPLES 512
+static uint8_t vdac_buffer[2 * VDAC_BUFFER_SAMPLES];
+static uint8 vdac_channel;
+static uint8 vdac_td[2];
+static int vdac_write_pos = VDAC_BUFFER_SAMPLES;
+
+static void setup_vdac_dma(void){
+    VDAC8_1_Start();
+    vdac_channel = DMA_AUDIO_DmaInitialize(1, 1, HI16((uint32) vdac_buffer), HI16((uint32) VDAC8_1_Data_PTR));
+    int half;
+    for (half = 0; half < 2; half++){
+        vdac_td[half] = CyDmaTdAllocate();
+    }
+    for (half = 0; half < 2; half++){
+        CyDmaTdSetConfiguration(vdac_td[half], VDAC_BUFFER_SAMPLES, vdac_td[!half], TD_INC_SRC_ADR);
+        CyDmaTdSetAddress(vdac_td[half], LO16((uint32) &vdac_buffer[half * VDAC_BUFFER_SAMPLES]), LO16((uint32) VDAC8_1_Data_PTR));
+    }
+    CyDmaChSetInitialTd(vdac_channel, vdac_td[0]);
+    CyDmaChEnable(vdac_channel, 1);
+    Timer_Audio_Start();
+}
+
+static void write_vdac(const int16_t* samples, int count){
+    uint8 td;
+    uint8 state;
+    CyDmaChStatus(vdac_channel, &td, &state);
+    int playing = td == vdac_td[1];
+    int i;
+    for (i = 0; i < count; i++){
+        if (vdac_write_pos / VDAC_BUFFER_SAMPLES == playing) break;
+        vdac_buffer[vdac_write_pos] = (uint8_t) ((samples[i] >> 8) + 128);
+        vdac_write_pos = (vdac_write_pos + 1) % (2 * VDAC_BUFFER_SAMPLES);
+    }
+}
+#endif
+
+// Turns the deltas up to time end into samples and sends them to the sink
+static void output_samples(Apu* apu, uint32_t end){
+    uint64_t pos = apu->buffer_frac + (uint64_t) (end - apu->buffer_time) * CYCLES_TO_SAMPLES;
+    apu->buffer_time = end;
+    apu->buffer_frac = (uint32_t) pos;
+    if (apu->sink == APU_SINK_NULL) return;
+
+    int count = pos >> 32;
+    int i;
+    for (i = 0; i < count; i++){
+        apu->sum += apu->deltas[i];
+        int32_t sample = apu->sum / BLEP_UNIT;
+        // high pass, since every level is positive
+        apu->dc += ((sample << 8) - apu->dc) >> 9;
+        sample -= apu->dc >> 8;
+        if (sample > INT16_MAX) sample = INT16_MAX;
+        if (sample < INT16_MIN) sample = INT16_MIN;
+        apu->samples[i] = sample;
+    }
+    memmove(apu->deltas, &apu->deltas[count], BLEP_TAPS * sizeof(int32_t));
+    memset(&apu->deltas[BLEP_TAPS], 0, count * sizeof(int32_t));
+
+    if (apu->sink == APU_SINK_CALLBACK){
+        apu->write_samples(apu->write_samples_ctx, apu->samples, count);
+    }
+#if APU_VDAC_OUTPUT
+    if (apu->sink == APU_SINK_VDAC_DMA){
+        write_vdac(apu->samples, count);
+    }
+#endif
+}
+
+void setup_apu(Apu* apu, Memory* mem, Arena* arena){
+    memset(apu, 0, sizeof(Apu));
+    apu->mem = mem;
+    apu->arena = arena;
+    apu->next_sequencer = SEQUENCER_PERIOD;
+#if APU_VDAC_OUTPUT
+    set_apu_sink(apu, APU_SINK_VDAC_DMA, NULL, NULL);
+#else
+    set_apu_sink(apu, APU_SINK_NULL, NULL, NULL);
+#endif
+}
+
+bool set_apu_sink(Apu* apu, ApuSink sink, void (*write_samples)(void* ctx, const int16_t* samples, int count), void* ctx){
+    if (sink != APU_SINK_NULL && !apu->deltas){
+        apu->deltas = arena_alloc(apu->arena, "apu deltas", APU_DELTAS_SIZE);
+        apu->samples = arena_alloc(apu->arena, "apu samples", APU_SAMPLES_SIZE);
+        if (!apu->deltas || !apu->samples){
+            apu->deltas = NULL;
+            apu->sink = APU_SINK_NULL;
+            return false;
+        }
+    }
+    apu->sink = sink;
+    apu->write_samples = write_samples;
+    apu->write_samples_ctx = ctx;
+#if APU_VDAC_OUTPUT
+    if (sink == APU_SINK_VDAC_DMA){
+        setup_vdac_dma();
+    }
+#endif
+    return true;
+}
+
+void run_apu(Apu* apu){
+    Memory* mem = apu->mem;
+    uint32_t now = mem->cycle_clock ? (uint32_t) *mem->cycle_clock * 4 : apu->time;
+    int next_write = 0;
+    do {
+        uint32_t end = now - apu->time > APU_MAX_BATCH_CYCLES ? apu->time + APU_MAX_BATCH_CYCLES : now;
+        replay(apu, end, &next_write);
+        output_samples(apu, end);
+    } while (apu->time != now);
+    mem->sound_write_count = 0;
+
+    uint8_t status = 0;
+    int channel;
+    for (channel = 0; channel < APU_CHANNEL_COUNT; channel++){
+        if (apu->channels[channel].on) status |= 1 << channel;
+    }
+    mem->sound_status = status;
+}
+
+void run_apu_hook(void* apu){
+    run_apu(apu);
+}
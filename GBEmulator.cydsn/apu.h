@@ -0,0 +1,84 @@
+/*
+Audio processing unit: the two square channels, the wave channel, the noise channel and the frame sequencer
+Nothing here runs per instruction. write_mem stores the sound registers and logs each write with its time,
+and run_apu replays the log once per frame (from the gpu's vblank hook), or sooner if the log fills up,
+synthesizing the whole batch in one go. Level changes are put into the output as band-limited steps
+(blep_table.h), so the output rate can be far below the gameboy's without aliasing
+*/
+#ifndef APU_H
+#define APU_H
+#include "memory.h"
+#include "blep_table.h"
+#include "arena.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+#define APU_SAMPLE_RATE 22050
+#define APU_CLOCK_HZ 4194304                // T-cycles per second
+#define APU_MAX_BATCH_CYCLES 65536          // T-cycles synthesized at once, about a frame
+#define APU_MAX_BATCH_SAMPLES ((APU_MAX_BATCH_CYCLES / (APU_CLOCK_HZ / APU_SAMPLE_RATE)) + 2)
+#define APU_CHANNEL_COUNT 4
+// Arena bytes the synthesis buffers take, allocated the first time a sink other than APU_SINK_NULL is selected
+#define APU_DELTAS_SIZE ((APU_MAX_BATCH_SAMPLES + BLEP_TAPS) * sizeof(int32_t))
+#define APU_SAMPLES_SIZE (APU_MAX_BATCH_SAMPLES * sizeof(int16_t))
+
+// Where run_apu sends finished samples
+typedef enum ApuSink {
+    APU_SINK_VDAC_DMA,   // VDAC8_1 through the DMA_AUDIO double buffer (APU_VDAC_OUTPUT only)
+    APU_SINK_CALLBACK,   // write_samples, e.g. a WAV file on the host
+    APU_SINK_NULL        // registers and channel status only, nothing synthesized
+} ApuSink;
+
+typedef struct ApuChannel {
+    bool on;                   // channel status bit in NR52
+    uint16_t length;           // length clocks left (counts down while length is enabled)
+    uint8_t volume;            // envelope volume, 0-15
+    uint8_t envelope_timer;
+    uint16_t freq;             // 11 bit frequency (square and wave)
+    uint32_t period;           // T-cycles per waveform step
+    uint32_t next_step;        // T-cycle of the next waveform step
+    uint8_t position;          // duty step (square) or sample (wave)
+    uint16_t lfsr;             // noise only
+    uint8_t level;             // current DAC input, 0-15
+    int32_t output;            // what the channel adds to the mix right now
+} ApuChannel;
+
+typedef struct Apu {
+    Memory* mem;
+    uint8_t regs[SOUND_SIZE];  // sound registers as of the replayed time
+    ApuChannel channels[APU_CHANNEL_COUNT];
+    int32_t channel_gain[APU_CHANNEL_COUNT];    // from NR50 and NR51
+    uint16_t shadow_freq;      // square 1 sweep
+    uint8_t sweep_timer;
+    bool sweep_enabled;
+    uint32_t time;             // T-cycle everything has been replayed up to
+    uint32_t next_sequencer;   // T-cycle of the next frame sequencer step
+    uint8_t sequencer_step;
+
+    // Band-limited synthesis: changes are added to deltas, which add up to the output
+    // deltas and samples come from arena and are only there while a sink other than APU_SINK_NULL is set
+    uint32_t buffer_time;      // T-cycle deltas[0] starts on
+    uint32_t buffer_frac;      // and how far into that sample it starts (32 bit fraction)
+    int32_t* deltas;           // APU_MAX_BATCH_SAMPLES + BLEP_TAPS
+    int32_t sum;
+    int32_t dc;                // slow average of sum, taken out of the output
+    int16_t* samples;          // APU_MAX_BATCH_SAMPLES
+    Arena* arena;
+
+    ApuSink sink;
+    void (*write_samples)(void* ctx, const int16_t* samples, int count);
+    void* write_samples_ctx;
+} Apu;
+
+// Initializes the apu, sending samples to the VDAC when APU_VDAC_OUTPUT is on and nowhere otherwise
+// The synthesis buffers are allocated from arena when they are first needed
+void setup_apu(Apu* apu, Memory* mem, Arena* arena);
+// Selects where samples go; write_samples is only used by APU_SINK_CALLBACK
+// Returns false, leaving the sink at APU_SINK_NULL, when the arena has no room for the synthesis buffers
+bool set_apu_sink(Apu* apu, ApuSink sink, void (*write_samples)(void* ctx, const int16_t* samples, int count), void* ctx);
+// Replays the logged sound writes up to now (mem->cycle_clock) and outputs the finished samples
+void run_apu(Apu* apu);
+// Same as run_apu, as a void* hook for the gpu's vblank and the sound write log
+void run_apu_hook(void* apu);
+
+#endif
@@ -0,0 +1,52 @@
+#include "arena.h"
+#include <project.h>
+#include "stdio.h"
+#include "string.h"
+
+void setup_arena(Arena* arena, uint8_t* base, uint32_t capacity){
+    memset(arena, 0, sizeof(Arena));
+    arena->base = base;
+    arena->capacity = capacity;
+}
+
+void* arena_alloc(Arena* arena, const char* name, uint32_t size){
+    if (size == 0) return NULL;
+    uint32_t aligned = (size + ARENA_ALIGN - 1) & ~(uint32_t) (ARENA_ALIGN - 1);
+    if (aligned > arena->capacity - arena->used || arena->num_blocks == ARENA_MAX_BLOCKS){
+        arena->refused += size;
+        return NULL;
+    }
+    ArenaBlock* block = &arena->blocks[arena->num_blocks++];
+    block->name = name;
+    block->offset = arena->used;
+    block->size = size;
+    arena->used += aligned;
+    uint8_t* data = arena->base + block->offset;
+    memset(data, 0, size);
+    return data;
+}
+
+void arena_report(const Arena* arena, void (*write_line)(void* ctx, const char* line), void* ctx){
+    char line[80];
+    int i;
+    for (i = 0; i < arena->num_blocks; i++){
+        const ArenaBlock* block = &arena->blocks[i];
+        sprintf(line, "arena 0x%04lX %6lu %s\r\n", (unsigned long) block->offset, (unsigned long) block->size, block->name);
+        write_line(ctx, line);
+    }
+    sprintf(line, "arena %lu of %lu bytes used, %lu free\r\n", (unsigned long) arena->used,
+        (unsigned long) arena->capacity, (unsigned long) (arena->capacity - arena->used));
+    write_line(ctx, line);
+    if (arena_over_budget(arena)){
+        sprintf(line, "arena OVER BUDGET: %lu more bytes wanted\r\n", (unsigned long) arena->refused);
+        write_line(ctx, line);
+    }
+}
+
+static void write_line_uart(void* ctx, const char* line){
+    UART_1_PutString(line);
+}
+
+void arena_report_uart(const Arena* arena){
+    arena_report(arena, write_line_uart, NULL);
+}
@@ -0,0 +1,47 @@
+/*
+One block of SRAM that the emulator's variable sized state is carved out of at setup, sized from the
+cartridge header and the features that are on, instead of every subsystem reserving its worst case
+Blocks are never freed. setup_emulator makes every allocation it knows of before the first instruction,
+so a layout that doesn't fit fails at boot instead of partway through a game
+*/
+#ifndef ARENA_H
+#define ARENA_H
+#include "stdint.h"
+#include "stdbool.h"
+
+#define ARENA_MAX_BLOCKS 8
+#define ARENA_ALIGN 4
+
+typedef struct ArenaBlock {
+    const char* name;
+    uint32_t offset;           // from the start of the arena
+    uint32_t size;
+} ArenaBlock;
+
+typedef struct Arena {
+    uint8_t* base;
+    uint32_t capacity;
+    uint32_t used;             // bytes handed out, alignment included
+    uint32_t refused;          // bytes asked for that didn't fit
+    ArenaBlock blocks[ARENA_MAX_BLOCKS];
+    int num_blocks;
+} Arena;
+
+// Hands out the capacity bytes at base (word aligned)
+void setup_arena(Arena* arena, uint8_t* base, uint32_t capacity);
+// A zeroed, word aligned block of size bytes, named for the report
+// Returns NULL, and counts the size as refused, when it doesn't fit; size 0 also gives NULL
+void* arena_alloc(Arena* arena, const char* name, uint32_t size);
+// true once anything has been refused
+static inline bool arena_over_budget(const Arena* arena){
+    return arena->refused != 0;
+}
+// Bytes still free
+static inline uint32_t arena_free(const Arena* arena){
+    return arena->capacity - arena->used;
+}
+// Writes the blocks, what is used and what is left, one line at a time through write_line
+void arena_report(const Arena* arena, void (*write_line)(void* ctx, const char* line), void* ctx);
+// Same as above, over UART_1
+void arena_report_uart(const Arena* arena);
+#endif
@@ -0,0 +1,37 @@
+// Generated by host/gen_blep_table.c (make -C host blep_table), do not edit
+#include "blep_table.h"
+
+const int16_t blep_table[BLEP_PHASES][BLEP_TAPS] = {
+    {18, -110, 359, -843, 1561, -2371, 3025, 29490, 3025, -2371, 1561, -843, 359, -110, 18, 0},
+    {17, -108, 347, -795, 1421, -2025, 2117, 29452, 3974, -2714, 1693, -887, 369, -111, 18, 0},
+    {17, -105, 332, -742, 1276, -1679, 1252, 29332, 4960, -3051, 1818, -925, 376, -110, 17, 0},
+    {16, -102, 315, -686, 1128, -1335, 434, 29131, 5981, -3378, 1932, -956, 380, -109, 17, 0},
+    {16, -98, 297, -627, 977, -997, -336, 28853, 7031, -3693, 2036, -982, 381, -106, 16, 0},
+    {15, -93, 277, -566, 824, -665, -1055, 28499, 8106, -3992, 2127, -999, 378, -103, 15, 0},
+    {14, -87, 256, -503, 672, -343, -1721, 28067, 9203, -4273, 2204, -1009, 372, -97, 13, 0},
+    {13, -82, 234, -439, 522, -34, -2334, 27565, 10317, -4531, 2266, -1011, 362, -91, 11, 0},
+    {12, -76, 211, -375, 374, 262, -2891, 26992, 11444, -4765, 2311, -1004, 348, -83, 8, 0},
+    {10, -69, 188, -311, 229, 543, -3394, 26350, 12577, -4970, 2339, -987, 330, -73, 6, 0},
+    {9, -63, 165, -248, 90, 807, -3840, 25646, 13712, -5144, 2348, -962, 308, -62, 2, 0},
+    {8, -56, 142, -186, -44, 1052, -4231, 24877, 14845, -5283, 2338, -926, 282, -50, -1, 1},
+    {7, -50, 119, -126, -171, 1277, -4566, 24057, 15970, -5386, 2307, -881, 251, -36, -5, 1},
+    {6, -44, 96, -68, -291, 1482, -4846, 23182, 17081, -5448, 2255, -825, 217, -21, -10, 2},
+    {5, -37, 74, -12, -403, 1666, -5072, 22257, 18174, -5467, 2182, -760, 178, -4, -15, 2},
+    {4, -31, 53, 41, -506, 1828, -5246, 21289, 19243, -5441, 2086, -685, 136, 14, -20, 3},
+    {3, -25, 33, 90, -600, 1968, -5368, 20283, 20283, -5368, 1968, -600, 90, 33, -25, 3},
+    {3, -20, 14, 136, -685, 2086, -5441, 19243, 21289, -5246, 1828, -506, 41, 53, -31, 4},
+    {2, -15, -4, 178, -760, 2182, -5467, 18174, 22257, -5072, 1666, -403, -12, 74, -37, 5},
+    {2, -10, -21, 217, -825, 2255, -5448, 17081, 23182, -4846, 1482, -291, -68, 96, -44, 6},
+    {1, -5, -36, 251, -881, 2307, -5386, 15970, 24057, -4566, 1277, -171, -126, 119, -50, 7},
+    {1, -1, -50, 282, -926, 2338, -5283, 14845, 24877, -4231, 1052, -44, -186, 142, -56, 8},
+    {0, 2, -62, 308, -962, 2348, -5144, 13712, 25646, -3840, 807, 90, -248, 165, -63, 9},
+    {0, 6, -73, 330, -987, 2339, -4970, 12577, 26350, -3394, 543, 229, -311, 188, -69, 10},
+    {0, 8, -83, 348, -1004, 2311, -4765, 11444, 26992, -2891, 262, 374, -375, 211, -76, 12},
+    {0, 11, -91, 362, -1011, 2266, -4531, 10317, 27565, -2334, -34, 522, -439, 234, -82, 13},
+    {0, 13, -97, 372, -1009, 2204, -4273, 9203, 28067, -1721, -343, 672, -503, 256, -87, 14},
+    {0, 15, -103, 378, -999, 2127, -3992, 8106, 28499, -1055, -665, 824, -566, 277, -93, 15},
+    {0, 16, -106, 381, -982, 2036, -3693, 7031, 28853, -336, -997, 977, -627, 297, -98, 16},
+    {0, 17, -109, 380, -956, 1932, -3378, 5981, 29131, 434, -1335, 1128, -686, 315, -102, 16},
+    {0, 17, -110, 376, -925, 1818, -3051, 4960, 29332, 1252, -1679, 1276, -742, 332, -105, 17},
+    {0, 18, -111, 369, -887, 1693, -2714, 3974, 29452, 2117, -2025, 1421, -795, 347, -108, 17},
+};
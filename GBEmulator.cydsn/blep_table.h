@@ -0,0 +1,16 @@
+/*
+Band-limited impulse used by the apu to put level changes into its output (see apu.c)
+blep_table.c is generated by host/gen_blep_table.c (make -C host blep_table)
+*/
+#ifndef BLEP_TABLE_H
+#define BLEP_TABLE_H
+#include "stdint.h"
+
+#define BLEP_PHASE_BITS 5
+#define BLEP_PHASES (1 << BLEP_PHASE_BITS)   // positions between two output samples a change can fall on
+#define BLEP_TAPS 16                         // output samples one change is spread over
+#define BLEP_UNIT 32768                      // every phase sums to this
+
+// Windowed sinc impulse per phase, delayed by BLEP_TAPS / 2 - 1 samples
+extern const int16_t blep_table[BLEP_PHASES][BLEP_TAPS];
+#endif
@@ -3,8 +3,17 @@
 #include "registers.h"
 #include "cpu.h"
 #include "instruction_set.h"
+#include "emumode.h"
+#include "stddef.h"
 
+// Code tick_boot also uses goes to SRAM (sram_code.h) only in the build after boot
+#ifdef CPU_BOOT_PHASE
+#define CPU_SRAM_CODE
+#else
+#define CPU_SRAM_CODE SRAM_CODE
+#endif
 
+#ifndef CPU_BOOT_PHASE
 void setup_cpu(Cpu* cpu, Memory* mem) {
     cpu->mem = mem;
     reset_cpu(cpu);
@@ -14,10 +23,51 @@ void setup_cpu(Cpu* cpu, Memory* mem) {
 void reset_cpu(Cpu* cpu) {
     cpu->inBios = true;
     reset_registers(&cpu->reg);
+    sync_interrupt_check(cpu);
 }
 
+void sync_interrupt_check(Cpu* cpu){
+    Memory* mem = cpu->mem;
+    mem->interrupt_mask = cpu->reg.ime ? INTERRUPT_MASK_ALL : 0;
+    // an EI request left from the previous instruction takes effect with this one
+    mem->interrupt_check = cpu->reg.ime_enable_req ? INTERRUPT_CHECK_EI_DUE : 0;
+    update_interrupt_check(mem);
+}
+#endif
+
+#if INTERRUPT_CHECK_CACHE_ON
+// Everything tick does when mem->interrupt_check is set: an EI taking effect, then the interrupt
+// to service, if any. Returns the extra machine cycles taken
+CPU_SRAM_CODE static int check_interrupts(Cpu* cpu){
+    Memory* mem = cpu->mem;
+    uint8_t check = mem->interrupt_check;
+    // the EI before this instruction takes effect (DI and RETI cancel it); one in this instruction waits for the next
+    if (check & INTERRUPT_CHECK_EI_DUE){
+        cpu->reg.ime = true;
+        mem->interrupt_mask = INTERRUPT_MASK_ALL;
+    }
+    cpu->reg.ime_enable_req = check & INTERRUPT_CHECK_EI_ARMED;
+    
+    int cycles_taken = 0;
+    uint8_t active_interrupts = mem->interrupt_enable & mem->interrupt_flag & mem->interrupt_mask;
+    if (active_interrupts){
+        // disable interrupts (until a reti can re-enable)
+        cpu->reg.ime = false;
+        mem->interrupt_mask = 0;
+        cycles_taken = 5;   // takes an additional 5 cycles to service interrupt
+        // the lowest bit wins: VBlank, LCD STAT, Timer, Serial, Joypad, with vectors 8 bytes apart from 0x40
+        int interrupt = __builtin_ctz(active_interrupts);
+        rst_vec(cpu, VBLANK_ISR_LOC + interrupt * 8);
+        mem->interrupt_flag &= ~(1 << interrupt);
+    }
+    mem->interrupt_check = (check & INTERRUPT_CHECK_EI_ARMED) ? INTERRUPT_CHECK_EI_DUE : 0;
+    update_interrupt_check(mem);
+    return cycles_taken;
+}
+#endif
+
 // Assumes that the pc is already incremented to point to the next instr
-static inline int execute_normal(Cpu* cpu, uint8_t instruction){
+CPU_SRAM_CODE static inline int execute_normal(Cpu* cpu, uint8_t instruction){
     switch (instruction){
         case 0x0: return nop(cpu); //NOP
         case 0x1: return ld_r16_n16(cpu, &cpu->reg.bc); //LD BC,u16
@@ -279,7 +329,7 @@ static inline int execute_normal(Cpu* cpu, uint8_t instruction){
     return 0;
 }
 
-static inline int execute_cb_prefix(Cpu* cpu, uint8_t instruction){
+CPU_SRAM_CODE static inline int execute_cb_prefix(Cpu* cpu, uint8_t instruction){
     switch (instruction){
         case 0x0: return rlc_r8(cpu, &cpu->reg.b); //RLC B
         case 0x1: return rlc_r8(cpu, &cpu->reg.c); //RLC C
@@ -541,16 +591,21 @@ static inline int execute_cb_prefix(Cpu* cpu, uint8_t instruction){
     return 0;
 }
 
-int tick(Cpu* cpu){
+// What comes before the opcode fetch of every instruction
+static inline void begin_instruction(Cpu* cpu, uint16_t pc){
+#if !INTERRUPT_CHECK_CACHE_ON
     // Handle EI calls (the effects are delayed by 1 instr)
     if (cpu->reg.ime_enable_req){
         cpu->reg.ime = true;
         cpu->reg.ime_enable_req = false;
     }
-    
+#endif
+    if (PROFILER_ON && cpu->profiler) profiler_begin(cpu->profiler, pc);
+}
+
+// Everything after the opcode fetch: the instruction, with pc already past the opcode, and its interrupt check
+static inline int execute_fetched(Cpu* cpu, uint8_t instruction){
     uint8_t cycles_taken;
-    // Fetch
-    uint8_t instruction = fetch_and_increment_pc(cpu);
 
     // Check for CB-prefixed instructions
     if (instruction == 0xCB) {
@@ -558,11 +613,19 @@ int tick(Cpu* cpu){
         // Have to read the next one
         uint8_t cb_instr = fetch_and_increment_pc(cpu);
         cycles_taken = execute_cb_prefix(cpu, cb_instr);
+        if (PROFILER_ON && cpu->profiler) profiler_end(cpu->profiler, true, cb_instr, cycles_taken);
     } else {
         // Regular instruction
         cycles_taken = execute_normal(cpu, instruction);
+        if (PROFILER_ON && cpu->profiler) profiler_end(cpu->profiler, false, instruction, cycles_taken);
     }
     
+#if INTERRUPT_CHECK_CACHE_ON
+    // Interrupt handling, only when an interrupt is pending with IME set or an EI is taking effect
+    if (cpu->mem->interrupt_check){
+        cycles_taken += check_interrupts(cpu);
+    }
+#else
     // Interrupt handling
     //Bit 0: VBlank   Interrupt (INT 40h) 
     //Bit 1: LCD STAT Interrupt (INT 48h) 
@@ -571,7 +634,8 @@ int tick(Cpu* cpu){
     //Bit 4: Joypad   Interrupt (INT 60h)  
     int interrupt_enable = cpu->mem->interrupt_enable;
     int interrupt_flag = cpu->mem->interrupt_flag;
-    int active_interrupts = interrupt_enable & interrupt_flag;
+    // IE and IF bits 5-7 don't belong to an interrupt
+    int active_interrupts = interrupt_enable & interrupt_flag & INTERRUPT_MASK_ALL;
     if (cpu->reg.ime && active_interrupts){
         // disable interrupts (until a reti can re-enable)
         cpu->reg.ime = false;
@@ -594,10 +658,57 @@ int tick(Cpu* cpu){
             cpu->mem->interrupt_flag &= ~INTERRUPT_ENABLE_JOYPAD_MASK;
         }
     }
+#endif
     
     return cycles_taken;
 }
 
+// One instruction and its interrupt check, inlined into both tick and tick_boot
+static inline int execute_instruction(Cpu* cpu){
+    begin_instruction(cpu, cpu->reg.pc);
+    // Fetch
+    uint8_t instruction = fetch_and_increment_pc(cpu);
+    return execute_fetched(cpu, instruction);
+}
 
+#ifdef CPU_BOOT_PHASE
+int tick_boot(Cpu* cpu){
+    return execute_instruction(cpu);
+}
+#else
+int tick(Cpu* cpu){
+    return execute_instruction(cpu);
+}
 
-
+SRAM_CODE int run_cycles(Cpu* cpu, int budget){
+    Memory* mem = cpu->mem;
+    int cycles_taken = 0;
+    uint32_t instrs = 0;
+    mem->stop_batch = false;
+#if REGISTER_PINNING_ON
+    // Experiment (off by default): the fetch keeps pc in a local and reads opcodes in ROM straight from
+    // the cartridge instead of calling fetch_mapped. This isn't real pinning: pc still goes through
+    // cpu->reg once per instruction, since the instruction helpers read operands, jump and push through
+    // the struct, and SP, A and F aren't pinned at all. It measured slower on the host
+    // An OAM DMA locks ROM for whole batches: the write that starts one ends its batch, and the
+    // emulator ends the next one when the lock does
+    const uint8_t* rom = mem->dma_cycles_left ? NULL : mem->rom;
+    uint16_t pc = cpu->reg.pc;
+    do {
+        begin_instruction(cpu, pc);
+        uint8_t instruction = rom && pc < ROM_END ? rom[pc] : fetch_mapped(mem, pc);
+        cpu->reg.pc = pc + 1;
+        cycles_taken += execute_fetched(cpu, instruction);
+        pc = cpu->reg.pc;
+        instrs++;
+    } while (cycles_taken < budget && !mem->stop_batch);
+#else
+    do {
+        cycles_taken += execute_instruction(cpu);
+        instrs++;
+    } while (cycles_taken < budget && !mem->stop_batch);
+#endif
+    cpu->batch_instrs = instrs;
+    return cycles_taken;
+}
+#endif
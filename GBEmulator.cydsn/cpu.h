@@ -4,17 +4,41 @@
 #include "registers.h"
 #include "stdint.h"
 #include "memory.h"
+#include "profiler.h"
+#include "emumode.h"
+#include "sram_code.h"
 typedef struct Cpu {
     Memory* mem;
     Registers reg;
     bool inBios;
+    Profiler* profiler;    // only used when PROFILER_ON; NULL disables profiling
+    uint32_t batch_instrs; // instructions run by the last run_cycles
 } Cpu;
 
+// cpu.c is built twice: as tick() for after boot, where the boot rom is never mapped and every
+// check for it compiles away, and as tick_boot() (cpu_boot.c) for while the boot rom is running
+#if SPECIALIZE_BOOT_PHASE && !defined(CPU_BOOT_PHASE)
+#define CPU_IN_BIOS(cpu) false
+#else
+#define CPU_IN_BIOS(cpu) ((cpu)->inBios)
+#endif
+
 void setup_cpu(Cpu* cpu, Memory* mem);
 // Handles one round of fetch/decode/execute
 // Returns the number of machine cycles taken for the instruction
 // 4 clock cycles == 1 machine cycle
+// Only valid once the boot rom is unmapped (inBios is false)
 int tick(Cpu* cpu);
+// Same as tick, for while the boot rom is mapped
+int tick_boot(Cpu* cpu);
+// Runs instructions (at least one) until they have taken at least budget machine cycles, or one writes an I/O register
+// (mem->stop_batch), which may move the caller's next event; the loop has tick inlined, so there is no
+// call per instruction. Returns the machine cycles taken; the number of instructions goes in batch_instrs
+// Only valid once the boot rom is unmapped; runs from SRAM with SRAM_HOT_CODE_ON
+SRAM_CODE int run_cycles(Cpu* cpu, int budget);
 // Resets the cpu to the starting state, clearing all registers etc
 void reset_cpu(Cpu *cpu);
+// Redoes mem->interrupt_check and interrupt_mask from scratch; needed after setting reg.ime,
+// reg.ime_enable_req, IE or IF directly instead of through instructions and write_mem
+void sync_interrupt_check(Cpu* cpu);
 #endif
\ No newline at end of file
@@ -0,0 +1,4 @@
+// The boot rom build of cpu.c: tick_boot(), which reads the boot rom while cpu->inBios is set
+// (see CPU_IN_BIOS in cpu.h)
+#define CPU_BOOT_PHASE
+#include "cpu.c"
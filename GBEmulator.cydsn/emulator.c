@@ -0,0 +1,211 @@
+#include "emulator.h"
+#include "string.h"
+#include "rom.h"
+#include "emumode.h"
+#include "stdio.h"
+
+bool setup_emulator(Emulator* emu, const uint8_t* cartridge){
+    memset(emu, 0, sizeof(Emulator));
+    setup_arena(&emu->arena, emu->arena_memory, EMULATOR_ARENA_SIZE);
+    setup_cpu(&emu->cpu, &emu->mem);
+    setup_mmio(&emu->mmio, &emu->mem);
+    setup_gpu(&emu->gpu, &emu->mem);
+    setup_timer(&emu->timer, &emu->mem);
+    setup_apu(&emu->apu, &emu->mem, &emu->arena);
+    setup_serial(&emu->serial, &emu->mem, SERIAL_OVERFLOW_POLICY);
+    reset_memory(&emu->mem);
+    // sound writes are logged against total_cycles and replayed once per frame, or when the log fills up
+    emu->mem.cycle_clock = &emu->total_cycles;
+    emu->mem.sound_log_full_hook = run_apu_hook;
+    emu->mem.sound_log_full_hook_ctx = &emu->apu;
+    emu->gpu.vblank_hook = run_apu_hook;
+    emu->gpu.vblank_hook_ctx = &emu->apu;
+    emu->mem.rom = cartridge ? cartridge : rom;
+    emu->mem.eram_size = cart_ram_size(emu->mem.rom);
+    emu->mem.eram = arena_alloc(&emu->arena, "cartridge ram", emu->mem.eram_size);
+    if (!emu->mem.eram) emu->mem.eram_size = 0;
+    // what the cartridge leaves goes to more tile row caches, short of room for the apu buffers
+    alloc_tile_row_caches(&emu->gpu, &emu->arena, APU_DELTAS_SIZE + APU_SAMPLES_SIZE);
+    emu->cpu.inBios = START_IN_BIOS;
+    if (!START_IN_BIOS) skip_boot_rom(emu);
+    return !arena_over_budget(&emu->arena);
+}
+
+// The (R) the boot rom draws next to the logo, one byte per row
+static const uint8_t registered_mark[8] = {0x3C, 0x42, 0xB9, 0xA5, 0xB9, 0xA5, 0x42, 0x3C};
+
+// Each bit of a nibble of the cartridge's logo becomes two pixels, and each row two rows:
+// a logo byte is the top or bottom half of tile 1-24, the (R) is tile 25
+static void draw_boot_logo(Memory* mem){
+    int i;
+    for (i = 0; i < CART_LOGO_SIZE * 2; i++){
+        uint8_t nibble = (mem->rom[CART_LOGO_LOC + i / 2] >> (i & 1 ? 0 : 4)) & 0x0F;
+        uint8_t row = 0;
+        int bit;
+        for (bit = 0; bit < 4; bit++){
+            if (nibble & (1 << bit)) row |= 3 << (bit * 2);
+        }
+        // two bytes per row, the second bitplane stays 0
+        mem->vram[0x10 + i * 4] = row;
+        mem->vram[0x10 + i * 4 + 2] = row;
+    }
+    for (i = 0; i < 8; i++){
+        mem->vram[0x190 + i * 2] = registered_mark[i];
+    }
+    // tiles 1-12 and 13-24 on two rows of the map, the (R) at the end of the first
+    for (i = 0; i < 12; i++){
+        mem->vram[0x9904 - VRAM_START + i] = 1 + i;
+        mem->vram[0x9924 - VRAM_START + i] = 13 + i;
+    }
+    mem->vram[0x9910 - VRAM_START] = 25;
+}
+
+void skip_boot_rom(Emulator* emu){
+    Memory* mem = &emu->mem;
+    Registers* reg = &emu->cpu.reg;
+    
+    // the boot rom clears VRAM before drawing the logo
+    memset(mem->vram, 0, VRAM_SIZE);
+    draw_boot_logo(mem);
+    
+    // Z set; H and C set unless the header checksum is 0
+    reg->af = mem->rom[CART_HEADER_CHECKSUM_LOC] ? 0x01B0 : 0x0180;
+    reg->bc = 0x0013;
+    reg->de = 0x00D8;
+    reg->hl = 0x014D;
+    reg->sp = 0xFFFE;
+    reg->pc = 0x0100;
+    reg->ime = false;
+    reg->ime_enable_req = false;
+    
+    mem->joyp = 0xCF;
+    mem->sc = 0x7E;
+    mem->timer_divider = 0xAB;
+    mem->timer_control = 0xF8;
+    mem->interrupt_flag = 0xE1;
+    mem->interrupt_enable = 0x00;
+    mem->lcdc = 0x91;
+    // LY is 0 and equals LYC; the mode bits are the gpu's
+    mem->lcdstatus = 0x80 | LCD_STAT_LY_LYC_EQ_REG_MASK | emu->gpu.mode;
+    mem->background_palette = 0xFC;
+    mem->obp0 = 0xFF;
+    mem->obp1 = 0xFF;
+    mem->boot = 0x01;
+    
+    // Sound on with the master volume and panning the boot rom sets; the registers that read back
+    // as 0xFF/0xBF etc. are 0 under their read masks. Channel 1 isn't retriggered, so the tail of
+    // the boot chime isn't played and NR52 reads 0xF0 instead of 0xF1
+    write_mem(mem, NR52_LOC, 0x80);
+    write_mem(mem, 0xFF11, 0x80);   // NR11
+    write_mem(mem, 0xFF12, 0xF3);   // NR12
+    write_mem(mem, 0xFF24, 0x77);   // NR50
+    write_mem(mem, 0xFF25, 0xF3);   // NR51
+    
+    emu->cpu.inBios = false;
+    sync_interrupt_check(&emu->cpu);
+}
+
+void report_emulator_layout(Emulator* emu, void (*write_line)(void* ctx, const char* line), void* ctx){
+    char line[96];
+    sprintf(line, "state %lu bytes: memory %lu, gpu %lu, apu %lu, arena %lu\r\n", (unsigned long) sizeof(Emulator),
+        (unsigned long) sizeof(Memory), (unsigned long) sizeof(Gpu), (unsigned long) sizeof(Apu), (unsigned long) EMULATOR_ARENA_SIZE);
+    write_line(ctx, line);
+    arena_report(&emu->arena, write_line, ctx);
+}
+
+void set_perf_stats(Emulator* emu, PerfStats* perf){
+    emu->perf = perf;
+    emu->gpu.perf = perf;
+}
+
+// Same as run_instruction, but timing every subsystem
+static int run_instruction_timed(Emulator* emu, bool boot){
+    PerfStats* perf = emu->perf;
+    unsigned long frame = emu->gpu.frame_count;
+    
+    PerfTicks start = perf_now();
+    bool dma_running = emu->mem.dma_cycles_left != 0;
+    int cycles_taken = boot ? tick_boot(&emu->cpu) : tick(&emu->cpu);
+    if (boot && emu->mem.boot){
+        emu->cpu.inBios = false;
+    }
+    perf_add_since(perf, PERF_CPU, start);
+    
+    start = perf_now();
+    tick_mmio(&emu->mmio);
+    perf_add_since(perf, PERF_MMIO, start);
+    
+    start = perf_now();
+    tick_gpu(&emu->gpu, cycles_taken);
+    perf_add_since(perf, PERF_GPU, start);
+    
+    start = perf_now();
+    tick_timer(&emu->timer, cycles_taken);
+    tick_serial(&emu->serial, cycles_taken);
+    if (dma_running) tick_dma(&emu->mem, cycles_taken);
+    perf_add_since(perf, PERF_TIMER, start);
+    
+    emu->total_cycles += cycles_taken;
+    emu->total_instrs++;
+    if (emu->gpu.frame_count != frame) perf_frame_done(perf);
+    return cycles_taken;
+}
+
+// boot is always a constant, so each caller gets its own copy with the other phase compiled out
+static inline int run_instruction(Emulator* emu, bool boot){
+    if (SUBSYSTEM_TIMING_ON && emu->perf) return run_instruction_timed(emu, boot);
+    
+    // a DMA started by this instruction has its whole lock still ahead of it
+    bool dma_running = emu->mem.dma_cycles_left != 0;
+    int cycles_taken = boot ? tick_boot(&emu->cpu) : tick(&emu->cpu);
+    if (boot && emu->mem.boot){
+        emu->cpu.inBios = false;
+    }
+    tick_mmio(&emu->mmio);
+    tick_gpu(&emu->gpu, cycles_taken);
+    tick_timer(&emu->timer, cycles_taken);
+    tick_serial(&emu->serial, cycles_taken);
+    if (dma_running) tick_dma(&emu->mem, cycles_taken);
+    emu->total_cycles += cycles_taken;
+    emu->total_instrs++;
+    return cycles_taken;
+}
+
+int tick_emulator_boot(Emulator* emu){
+    return run_instruction(emu, true);
+}
+
+int tick_emulator_booted(Emulator* emu){
+    return run_instruction(emu, false);
+}
+
+int tick_emulator(Emulator* emu){
+    if (emu->cpu.inBios){
+        return run_instruction(emu, true);
+    }
+    return run_instruction(emu, false);
+}
+
+int tick_emulator_batch(Emulator* emu){
+    if (emu->cpu.inBios) return run_instruction(emu, true);
+    if (SUBSYSTEM_TIMING_ON && emu->perf) return run_instruction_timed(emu, false);
+    
+    // nothing the cpu can see changes before the soonest event, so the subsystems can wait until then
+    int budget = gpu_cycles_to_event(&emu->gpu);
+    int timer_budget = timer_cycles_to_event(&emu->timer);
+    if (timer_budget < budget) budget = timer_budget;
+    if (emu->mem.serial_cycles_left && emu->mem.serial_cycles_left < budget) budget = emu->mem.serial_cycles_left;
+    // the end of an OAM DMA's bus lock is an event too; writing OAM_DMA_LOC ends the batch that starts one
+    bool dma_running = emu->mem.dma_cycles_left != 0;
+    if (dma_running && emu->mem.dma_cycles_left < budget) budget = emu->mem.dma_cycles_left;
+    
+    int cycles_taken = run_cycles(&emu->cpu, budget);
+    tick_mmio(&emu->mmio);
+    tick_gpu(&emu->gpu, cycles_taken);
+    tick_timer(&emu->timer, cycles_taken);
+    tick_serial(&emu->serial, cycles_taken);
+    if (dma_running) tick_dma(&emu->mem, cycles_taken);
+    emu->total_cycles += cycles_taken;
+    emu->total_instrs += emu->cpu.batch_instrs;
+    return cycles_taken;
+}
@@ -0,0 +1,57 @@
+/*
+Holds all of the state for one emulated Game Boy so that several can run side by side
+*/
+#ifndef EMULATOR_H
+#define EMULATOR_H
+#include "stdint.h"
+#include "cpu.h"
+#include "gpu.h"
+#include "memory.h"
+#include "mmio.h"
+#include "timer.h"
+#include "apu.h"
+#include "serial.h"
+#include "perfstats.h"
+#include "arena.h"
+typedef struct Emulator {
+    Cpu cpu;
+    Gpu gpu;
+    Memory mem;
+    Mmio mmio;
+    Timer timer;
+    Apu apu;
+    Serial serial;
+    unsigned long total_cycles;   // machine cycles elapsed since setup
+    unsigned long total_instrs;   // instructions executed since setup
+    PerfStats* perf;              // only used when SUBSYSTEM_TIMING_ON; NULL disables timing
+    Arena arena;                  // cartridge ram, tile row caches and whatever else is sized at setup
+    uint8_t arena_memory[EMULATOR_ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+} Emulator;
+
+// Wires all subsystems of the emulator together and resets them
+// cartridge points to the 0x8000 byte rom image to run; NULL uses the rom built into rom.c
+// Returns false when what the cartridge and the features that are on need doesn't fit in
+// EMULATOR_ARENA_SIZE; the emulator must not be run then (report_emulator_layout says what is missing)
+bool setup_emulator(Emulator* emu, const uint8_t* cartridge);
+// Unmaps the boot rom and loads the registers, I/O registers and logo in VRAM the DMG boot rom leaves
+// behind, so the cartridge starts at 0x0100 straight away; setup_emulator does this when START_IN_BIOS is false
+void skip_boot_rom(Emulator* emu);
+// Writes the size of the fixed state and the arena's blocks, one line at a time through write_line
+void report_emulator_layout(Emulator* emu, void (*write_line)(void* ctx, const char* line), void* ctx);
+// Attaches (or with NULL, detaches) subsystem timing instrumentation
+void set_perf_stats(Emulator* emu, PerfStats* perf);
+// Runs one instruction, then advances the gpu, timer, serial port and mmio by the cycles it took
+// Returns the number of machine cycles taken
+int tick_emulator(Emulator* emu);
+// Same as tick_emulator, for callers that run the boot rom in its own loop:
+// tick_emulator_boot until cpu.inBios clears (the boot rom writes BOOT), then tick_emulator_booted,
+// which has no boot rom checks at all
+int tick_emulator_boot(Emulator* emu);
+int tick_emulator_booted(Emulator* emu);
+// Same as calling tick_emulator until the next gpu, timer or serial event (at most a scanline),
+// with the same results, but with the instructions run back to back by run_cycles and the subsystems
+// advanced once at the end (while the boot rom runs, or with timing attached, it runs one instruction)
+// The one difference: sound writes are timed from the start of their batch, up to a scanline early
+// Returns the number of machine cycles taken
+int tick_emulator_batch(Emulator* emu);
+#endif
@@ -3,14 +3,67 @@ This file contains precompiler definitions that change the function of the emula
 */
 #ifndef EMU_MODE_H
 #define EMU_MODE_H
+#include "stdbool.h"    // so the true/false flags below also work in #if
 
 #define GB_SERIAL_PASSTHROUGH true        // whether or not to pass through GB serial 
+#define SERIAL_OVERFLOW_POLICY SERIAL_OVERFLOW_DROP   // when the passthrough ring is full: DROP or BLOCK (serial.h)
+#ifndef SERIAL_TX_ISR_ON
+#define SERIAL_TX_ISR_ON false              // drain the passthrough ring from isr_uart_tx on UART_1's TX FIFO not full instead of the main loop (needs it in TopDesign)
+#endif
+
+#ifndef SPECIALIZE_BOOT_PHASE
+#define SPECIALIZE_BOOT_PHASE true          // separate cpu build for the boot rom, so the one after boot has no boot rom checks (see cpu.h)
+#endif
+#ifndef FAST_RAM_ACCESS_ON
+#define FAST_RAM_ACCESS_ON true             // stack and (HL) accesses in WRAM/HRAM skip the full fetch/write_mem (see memory.h)
+#endif
+#ifndef WORD_PIXEL_WRITES_ON
+#define WORD_PIXEL_WRITES_ON true           // bg/window lines go out 8 pixels at a time as 32 bit stores through per palette colors (see gpu.c)
+#endif
+#ifndef INTERRUPT_CHECK_CACHE_ON
+#define INTERRUPT_CHECK_CACHE_ON true       // tick tests one byte kept up to date on IE/IF/IME changes instead of IE & IF with IME (see cpu.c)
+#endif
+#ifndef REGISTER_PINNING_ON
+#define REGISTER_PINNING_ON false           // experiment: run_cycles fetches with pc in a local, reading ROM opcodes directly (see cpu.c); slower on the host, not measured on the PSoC
+#endif
+#ifndef IO_REGISTER_TABLE_ON
+#define IO_REGISTER_TABLE_ON true           // plain I/O registers are read and written straight in mem->io, without the switch (see memory.c)
+#endif
+#ifndef ALU_LOOKUP_TABLES_ON
+#define ALU_LOOKUP_TABLES_ON true           // DAA/INC/DEC/zero flags from const tables (alu_tables.c, ~5KB); false computes them
+#endif
+#ifndef SRAM_HOT_CODE_ON
+#define SRAM_HOT_CODE_ON false              // copy run_cycles, fetch_mapped, write_mem, renderLine and their tables to SRAM at startup (see sram_code.h)
+#endif
     
 #define DEBUG_MODE false
+
+#define DEFAULT_PALETTE PALETTE_GRAYSCALE   // palette preset (palette.h) every layer starts in
+#define OUTPUT_SCALE OUTPUT_SCALE_1X        // size on the TFT (gpu.h): 1X, 1_5X or 2X, as long as it fits the panel (tft.h)
+#ifndef EMULATOR_ARENA_SIZE
+#define EMULATOR_ARENA_SIZE 0x2100          // bytes for the state sized at setup: cartridge ram, the gpu's tile row caches and the apu buffers (see arena.h)
+#endif
+#ifndef APU_VDAC_OUTPUT
+#define APU_VDAC_OUTPUT false               // play the apu on VDAC8_1 through DMA_AUDIO, paced by Timer_Audio at APU_SAMPLE_RATE (needs all three in TopDesign)
+#endif
+
+#ifndef PROFILER_ON
+#define PROFILER_ON false                   // per-opcode profiler (see profiler.h); can be overridden from the command line
+#endif
+#define PROFILER_REPORT_FRAME 600           // send the profile over serial once, after this many frames
+
+#ifndef SUBSYSTEM_TIMING_ON
+#define SUBSYSTEM_TIMING_ON false           // time spent per subsystem (see perfstats.h); can be overridden from the command line
+#endif
+#define SUBSYSTEM_TIMING_REPORT_INTERVAL_FRAMES 60   // report the breakdown over serial every this many frames
     
-#define DEBUG_MODE_STUB_LY_0x90 false       //stubs the LY register to value 0x90
+#ifndef DEBUG_MODE_STUB_LY_0x90
+#define DEBUG_MODE_STUB_LY_0x90 false       //stubs the LY register to value 0x90 (what Gameboy-Doctor logs expect)
+#endif
 #define DEBUG_TRACE_THROUGH_SERIAL false    // enable trace mode over serial 
 #define DEBUG_TRACE_THROUGH_SERIAL_BREAKPOINT 0x0100   // where to start serial trace
+#define TRACE_BINARY_THROUGH_SERIAL false   // compact binary trace over serial (see trace.h), works outside DEBUG_MODE
+#define TRACE_BINARY_START_PC 0x0100        // where to start the binary trace
     
 #define DEBUG_BREAKPOINT_ON false
 #define DEBUG_BREAKPOINT 0x0100
@@ -21,6 +74,7 @@ This file contains precompiler definitions that change the function of the emula
 #define TETRIS 0
 #define DR_MARIO 14
 // CPU Test ROMS
+// Pass/fail is checked by host/build/romtest; the results below are from its last run
 #define TEST_ROM_CPU_INSTRS_1_SPECIAL 1             // Passed
 #define TEST_ROM_CPU_INSTRS_2_INTERRUPTS 2          // Fail
 #define TEST_ROM_CPU_INSTRS_3_OP_SP_HL 3            // Passed
@@ -37,12 +91,17 @@ This file contains precompiler definitions that change the function of the emula
 #define TEST_WINDOW_SCROLLING 13
     
 #define CUSTOM_TEST 99
-// ROM selection
+// ROM selection (can be overridden from the compiler command line)
+#ifndef ROM
 #define ROM TETRIS
+#endif
 
     
     
+// false skips the boot rom: the emulator starts at 0x0100 in the state the DMG boot rom leaves (skip_boot_rom)
+#ifndef START_IN_BIOS
 #define START_IN_BIOS true
+#endif
 #define CUSTOM_BIOS 0
 #define ORIGINAL_BIOS 1
 #define BIOS CUSTOM_BIOS
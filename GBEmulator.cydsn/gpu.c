@@ -3,7 +3,6 @@
 #include "emumode.h"
 #include "stdio.h"
 #include "stdlib.h"
-const uint16_t COLORS[4]  = {0xF800, 0xF80F, 0x00DD, 0xFFEE};
 
 #define VBLANK_MODE 1
 #define HBLANK_MODE 0
@@ -16,9 +15,6 @@ const uint16_t COLORS[4]  = {0xF800, 0xF80F, 0x00DD, 0xFFEE};
 #define VBLANK_TIME_MACHINE_CYCLES 1140   //4560 clock cycles => 1140 m cycles
 
 
-#define LINE_SPI_DMA_BUFFER_SIZE 320    // Each pixel is 2 bytes => 160 * 2 = 320
-uint8_t line_spi_dma_buffer[LINE_SPI_DMA_BUFFER_SIZE];   // dma data transfer buffer
-
 static inline int8_t safe_convert(uint8_t x) {
     return x < 128 ? x : x - 256;
 }
@@ -40,39 +36,106 @@ static inline uint8_t color_index_from_pxindex(uint8_t color_reg, uint8_t pxinde
     }
 }
 void setup_gpu(Gpu* gpu, Memory* mem){
-    if (!DEBUG_MODE){
+    gpu->mem = mem;
+    gpu->bgp_built = 0x100;
+    gpu->obp_built[0] = 0x100;
+    gpu->obp_built[1] = 0x100;
+    set_palette_preset(gpu, DEFAULT_PALETTE);
+    set_frame_sink(gpu, DEBUG_MODE ? FRAME_SINK_NULL : FRAME_SINK_SPI_DMA, NULL);
+}
+
+bool alloc_tile_row_caches(Gpu* gpu, Arena* arena, uint32_t keep_free){
+    uint32_t spare = arena_free(arena) > keep_free ? arena_free(arena) - keep_free : 0;
+    int count = 1;
+    while (count < TILE_MAP_ROWS && 2 * 2 * count * sizeof(TileRowCache) <= spare) count *= 2;
+    gpu->row_caches = arena_alloc(arena, "tile row caches", 2 * count * sizeof(TileRowCache));
+    if (!gpu->row_caches) return false;
+    gpu->row_cache_count = count;
+    int i;
+    for (i = 0; i < 2 * count; i++){
+        gpu->row_caches[i].map_row_start = -1;
+    }
+    return true;
+}
+
+void set_layer_palette(Gpu* gpu, PaletteLayer layer, const Palette* palette){
+    int shade;
+    for (shade = 0; shade < 4; shade++){
+        // The TFT takes RGB565 big endian, so swapping the bytes once here
+        // lets renderLine store colors as (little endian) halfwords
+        uint16_t color = palette->shades[shade];
+        gpu->layer_colors[layer][shade] = (uint16_t) ((color >> 8) | (color << 8));
+    }
+    // the colors made from the palette registers are stale now
+    if (layer == PALETTE_LAYER_BG){
+        gpu->bgp_built = 0x100;
+    } else {
+        gpu->obp_built[layer - PALETTE_LAYER_OBJ0] = 0x100;
+    }
+}
+
+void set_palette_preset(Gpu* gpu, PalettePreset preset){
+    int layer;
+    for (layer = 0; layer < PALETTE_LAYER_COUNT; layer++){
+        set_layer_palette(gpu, layer, &palette_presets[preset]);
+    }
+}
+
+void set_frame_sink(Gpu* gpu, FrameSink sink, uint8_t* framebuffer){
+    gpu->sink = sink;
+    gpu->framebuffer = framebuffer;
+    gpu->line_buffer = gpu->line_spi_dma_buffer;
+    gpu->output_scale = sink == FRAME_SINK_SPI_DMA ? OUTPUT_SCALE : OUTPUT_SCALE_1X;
+    if (sink == FRAME_SINK_SPI_DMA){
         // Initialize DMA here
-        setupDma(&line_spi_dma_buffer[0], LINE_SPI_DMA_BUFFER_SIZE);
+        setupDma(&gpu->line_spi_dma_buffer[0], LINE_SPI_DMA_BUFFER_SIZE);
     }
-    gpu->mem = mem;
 }
 
+void set_output_scale(Gpu* gpu, uint8_t scale){
+    gpu->output_scale = scale;
+}
 
-static inline void write_colorindx_to_dma_buff(uint8_t colorindex, int x_coord){
-    switch (colorindex){
-        case 0:
-            line_spi_dma_buffer[2 * x_coord] = 0xFF;
-            line_spi_dma_buffer[2 * x_coord + 1] = 0xFF;
-        break;
-        case 1:
-            line_spi_dma_buffer[2 * x_coord] = 0xC6;
-            line_spi_dma_buffer[2 * x_coord + 1] = 0x18;
+// Spins until the SPI DMA is done with the line buffer
+static inline void wait_for_dma(Gpu* gpu){
+    if (SUBSYSTEM_TIMING_ON && gpu->perf){
+        PerfTicks start = perf_now();
+        while (!isDmaReady()){};
+        perf_add_since(gpu->perf, PERF_DMA_WAIT, start);
+    } else {
+        while (!isDmaReady()){};
+    }
+}
+
+// Writes the pixel at x_coord into the line buffer, widened to the output scale
+static inline void write_px_to_line_buff(Gpu* gpu, uint16_t color, int x_coord){
+    uint16_t* line = (uint16_t*) gpu->line_buffer;
+    switch (gpu->output_scale){
+        case OUTPUT_SCALE_1X:
+            line[x_coord] = color;
         break;
-        case 2:
-            line_spi_dma_buffer[2 * x_coord] = 0x7B;
-            line_spi_dma_buffer[2 * x_coord + 1] = 0xEF;
+        case OUTPUT_SCALE_1_5X: {
+            // even pixels take two output pixels, odd ones one
+            int out = (3 * x_coord + 1) / 2;
+            line[out] = color;
+            if ((x_coord & 1) == 0) line[out + 1] = color;
+        }
         break;
-        case 3:
-            line_spi_dma_buffer[2 * x_coord] = 0x00;
-            line_spi_dma_buffer[2 * x_coord + 1] = 0x00;
+        case OUTPUT_SCALE_2X:
+            line[2 * x_coord] = color;
+            line[2 * x_coord + 1] = color;
         break;
     }
 }
 
+static inline void write_colorindx_to_line_buff(Gpu* gpu, PaletteLayer layer, uint8_t colorindex, int x_coord){
+    write_px_to_line_buff(gpu, gpu->layer_colors[layer][colorindex], x_coord);
+}
+
 // Renders one of the 40 sprites in OAM on the current scan line, assuming it is possible
 // i.e. requires (sprite_y <= mem->current_scan_line && (sprite_y + 8) > mem->current_scan_line) in 8x8 mode
 //            or (sprite_y <= mem->current_scan_line && (sprite_y + 16) > mem->current_scan_line) in 8x16 mode
-static void render_sprite_on_scanline(Gpu* gpu, Memory* mem, uint8_t sprite_num, bool obj_size8x16){
+SRAM_CODE static void render_sprite_on_scanline(Gpu* gpu, Memory* mem, uint8_t sprite_num, bool obj_size8x16){
     int sprite_offset = sprite_num * 4; //4 bytes per sprite
     int sprite_y = (int) mem->oam[sprite_offset] - 16;     // first byte is y  + 16
     int sprite_x = (int) mem->oam[sprite_offset + 1] - 8; //second byte is x + 8
@@ -105,7 +168,6 @@ static void render_sprite_on_scanline(Gpu* gpu, Memory* mem, uint8_t sprite_num,
     uint8_t high = mem->vram[tile_start_addr + 2 * tile_y_offset + 1];
     
     
-    uint8_t sprite_color_palette = pallete_obp1 ? mem->obp1 : mem->obp0;
     int x = sprite_x;
     int j;
     for (j=7;j>=0;j--){
@@ -120,8 +182,13 @@ static void render_sprite_on_scanline(Gpu* gpu, Memory* mem, uint8_t sprite_num,
                 && (!bg_has_priority || (bg_has_priority && gpu->line_bg_px_indx_buffer[x] == 0))){
                     
                 // finally draw the pixel
+#if WORD_PIXEL_WRITES_ON
+                write_px_to_line_buff(gpu, gpu->obj_colors[pallete_obp1][pxindex], x);
+#else
+                uint8_t sprite_color_palette = pallete_obp1 ? mem->obp1 : mem->obp0;
                 uint8_t color_index = color_index_from_pxindex(sprite_color_palette, pxindex);
-                write_colorindx_to_dma_buff(color_index, x);    
+                write_colorindx_to_line_buff(gpu, PALETTE_LAYER_OBJ0 + pallete_obp1, color_index, x);    
+#endif
             }  
         }
         x++;   
@@ -129,27 +196,284 @@ static void render_sprite_on_scanline(Gpu* gpu, Memory* mem, uint8_t sprite_num,
 }
 
 
-//Called at the end of every PIXEL_TRANSFER_MODE
-// Renders the current line
+// Returns true if sprite_num_1 has to be drawn before sprite_num_2
+// Sprites drawn later end up on top, so the sprite with the larger x is drawn first
+static inline bool sprite_drawn_before(Gpu* gpu, int sprite_num_1, int sprite_num_2){
+    int x1 = gpu->sprite_nums_to_x_coord[sprite_num_1];
+    int x2 = gpu->sprite_nums_to_x_coord[sprite_num_2];
+    if (x1 != x2) return x1 > x2;
+    // break ties by choosing the sprite that comes first in oam
+    return sprite_num_1 > sprite_num_2;
+}
 
-// the following arrays are used to sort sprites (handles priority)
-int sprite_nums_to_display[10];  // used to hold sprites for sorting
-int sprite_nums_to_x_coord[40];
+// Sorts the sprites to display in drawing order (handles priority)
+// At most 10 sprites per line, so an insertion sort is plenty
+SRAM_CODE static void sort_sprites_by_priority(Gpu* gpu, int sprite_display_count){
+    int i;
+    for (i = 1; i < sprite_display_count; i++){
+        int sprite_num = gpu->sprite_nums_to_display[i];
+        int j = i - 1;
+        while (j >= 0 && sprite_drawn_before(gpu, sprite_num, gpu->sprite_nums_to_display[j])){
+            gpu->sprite_nums_to_display[j + 1] = gpu->sprite_nums_to_display[j];
+            j--;
+        }
+        gpu->sprite_nums_to_display[j + 1] = sprite_num;
+    }
+}
 
-// Comparator that gives correct priority sorting
-int compare_sprite_nums_priority(const void * a, const void * b)
-{
-  int sprite_num_1 = *(int *)a, sprite_num_2 = *(int *)b;
-  if(sprite_nums_to_x_coord[sprite_num_1] > sprite_nums_to_x_coord[sprite_num_2]) // a < b
-    return -1;
-  else if(sprite_nums_to_x_coord[sprite_num_1] == sprite_nums_to_x_coord[sprite_num_2]) // a == b
-    // break ties by choosing the sprite that comes first in oam
-    return sprite_num_2 - sprite_num_1;
-  else 
-    return 1;  // a > b
+// Where each tile of the tile map row at map_row_start starts in vram, from the cache when possible
+// layer is 0 for the background, 1 for the window
+SRAM_CODE static const uint16_t* tile_row_data_offsets(Gpu* gpu, int layer, Memory* mem, int map_row_start, bool data_area_1){
+    int map_row = (map_row_start - 0x1800) / TILE_MAP_WIDTH;
+    TileRowCache* cache = &gpu->row_caches[layer * gpu->row_cache_count + (map_row & (gpu->row_cache_count - 1))];
+    if (cache->map_row_start != map_row_start || cache->data_area_1 != data_area_1 ||
+        cache->tile_map_writes != mem->tile_map_writes){
+        int i;
+        for (i = 0; i < TILE_MAP_WIDTH; i++){
+            int tile_id = mem->vram[map_row_start + i];
+            if (!data_area_1){ //bit 4 in LCDC specifies whether or not to use 0x8000 base addr unsigned
+                // when bit 4 is low, 9000 is the base pointer and the index is signed
+                if (tile_id < 128) tile_id  += 256;
+            }
+            cache->tile_data_offsets[i] = tile_id * 16; //each tile is 16 bytes
+        }
+        cache->map_row_start = map_row_start;
+        cache->data_area_1 = data_area_1;
+        cache->tile_map_writes = mem->tile_map_writes;
+    }
+    return cache->tile_data_offsets;
+}
+
+#if WORD_PIXEL_WRITES_ON
+// Each byte of a tile row with its bits spread out to every other bit: bit i moves to bit 2i
+// spread[low] | (spread[high] << 1) gives the 8 pixel indices of the row, 2 bits each, leftmost pixel on top
+#define SPREAD(b) ((((b) & 0x01) << 0) | (((b) & 0x02) << 1) | (((b) & 0x04) << 2) | (((b) & 0x08) << 3) | \
+                   (((b) & 0x10) << 4) | (((b) & 0x20) << 5) | (((b) & 0x40) << 6) | (((b) & 0x80) << 7))
+// 4 pixel indices (2 bits each, leftmost on top) to a word holding one index per byte, leftmost first in memory
+#define INDEX_BYTES(b) ((((b) >> 6) & 0x3) | ((((b) >> 4) & 0x3) << 8) | ((((b) >> 2) & 0x3) << 16) | (((uint32_t) (b) & 0x3) << 24))
+#define TABLE_4(f, n) f(n), f(n + 1), f(n + 2), f(n + 3)
+#define TABLE_16(f, n) TABLE_4(f, n), TABLE_4(f, n + 4), TABLE_4(f, n + 8), TABLE_4(f, n + 12)
+#define TABLE_64(f, n) TABLE_16(f, n), TABLE_16(f, n + 16), TABLE_16(f, n + 32), TABLE_16(f, n + 48)
+#define TABLE_256(f) TABLE_64(f, 0), TABLE_64(f, 64), TABLE_64(f, 128), TABLE_64(f, 192)
+static const uint16_t tile_byte_spread[256] SRAM_TABLE(tile_byte_spread) = { TABLE_256(SPREAD) };
+static const uint32_t px_index_bytes[256] SRAM_TABLE(px_index_bytes) = { TABLE_256(INDEX_BYTES) };
+
+// Remakes the colors of each palette register that (or whose layer palette) changed since the last line
+SRAM_CODE static void update_palette_colors(Gpu* gpu, Memory* mem){
+    if (gpu->bgp_built != mem->background_palette){
+        int n;
+        for (n = 0; n < 4; n++){
+            gpu->bg_colors[n] = gpu->layer_colors[PALETTE_LAYER_BG][color_index_from_pxindex(mem->background_palette, n)];
+        }
+        for (n = 0; n < 16; n++){
+            gpu->bg_pixel_pair_colors[n] = gpu->bg_colors[n >> 2] | ((uint32_t) gpu->bg_colors[n & 0x3] << 16);
+        }
+        gpu->bgp_built = mem->background_palette;
+    }
+    uint8_t obp[2] = {mem->obp0, mem->obp1};
+    int i;
+    for (i = 0; i < 2; i++){
+        if (gpu->obp_built[i] == obp[i]) continue;
+        const uint16_t* obj_colors = gpu->layer_colors[PALETTE_LAYER_OBJ0 + i];
+        int px;
+        for (px = 0; px < 4; px++){
+            gpu->obj_colors[i][px] = obj_colors[color_index_from_pxindex(obp[i], px)];
+        }
+        gpu->obp_built[i] = obp[i];
+    }
+}
+
+// The 8 pixel indices of one tile row, 2 bits each, leftmost pixel on top
+static inline uint32_t tile_row_pixels(const uint8_t* tile_row){
+    return tile_byte_spread[tile_row[0]] | (tile_byte_spread[tile_row[1]] << 1);
+}
+
+// Writes the colors of a line of pixel indices (8 per halfword, as made below) into the line buffer
+// Each group of 8 pixels takes 4 word stores at 1x, 6 at 1.5x and 8 at 2x
+SRAM_CODE static void write_bg_line(Gpu* gpu, const uint16_t* line_pixels){
+    uint32_t* line_words = (uint32_t*) gpu->line_buffer;
+    const uint16_t* bg_colors = gpu->bg_colors;
+    int group;
+    switch (gpu->output_scale){
+        case OUTPUT_SCALE_1X: {
+            const uint32_t* colors = gpu->bg_pixel_pair_colors;
+            for (group = 0; group < DISPLAY_WIDTH / 8; group++){
+                uint16_t px = line_pixels[group];
+                line_words[0] = colors[px >> 12];
+                line_words[1] = colors[(px >> 8) & 0xF];
+                line_words[2] = colors[(px >> 4) & 0xF];
+                line_words[3] = colors[px & 0xF];
+                line_words += 4;
+            }
+        }
+        break;
+        case OUTPUT_SCALE_1_5X:
+            for (group = 0; group < DISPLAY_WIDTH / 8; group++){
+                uint16_t px = line_pixels[group];
+                int half;
+                // pixels a b c d go out as a a b c c d
+                for (half = 1; half >= 0; half--){
+                    uint8_t four_px = px >> (8 * half);
+                    uint32_t a = bg_colors[four_px >> 6];
+                    uint32_t b = bg_colors[(four_px >> 4) & 0x3];
+                    uint32_t c = bg_colors[(four_px >> 2) & 0x3];
+                    uint32_t d = bg_colors[four_px & 0x3];
+                    line_words[0] = a | (a << 16);
+                    line_words[1] = b | (c << 16);
+                    line_words[2] = c | (d << 16);
+                    line_words += 3;
+                }
+            }
+        break;
+        case OUTPUT_SCALE_2X:
+            for (group = 0; group < DISPLAY_WIDTH / 8; group++){
+                uint16_t px = line_pixels[group];
+                int shift;
+                for (shift = 14; shift >= 0; shift -= 2){
+                    uint32_t color = bg_colors[(px >> shift) & 0x3];
+                    *line_words++ = color | (color << 16);
+                }
+            }
+        break;
+    }
+}
+
+// Draws the background and window of the current line a tile's width (8 pixels) at a time
+// The pixel indices of each group of 8 screen pixels are put together in a halfword first,
+// then written out with 2 word stores to line_bg_px_indx_buffer and 4 to the line buffer
+SRAM_CODE static void render_bg_and_window(Gpu* gpu, Memory* mem, bool bg_map_area_1, bool data_area_1, bool window_enable, bool window_map_area_1){
+    uint16_t line_pixels[DISPLAY_WIDTH / 8];
+    
+    int bg_map_offset = bg_map_area_1 ? 0x1C00 : 0x1800;
+    int bg_y = mem->current_scan_line + mem->scroll_y;
+    int bgmap_row_start = bg_map_offset + ((bg_y/8) % 32) * 32;
+    int bg_tile_line = bg_y % 8;
+    const uint16_t* tile_data_offsets = tile_row_data_offsets(gpu, 0, mem, bgmap_row_start, data_area_1);
+    
+    // each group takes the last 8 - (SCX & 7) pixels of one tile and the first SCX & 7 of the next
+    int fine_x = mem->scroll_x & 7;
+    int tile = mem->scroll_x / 8;
+    uint32_t pixels = tile_row_pixels(&mem->vram[tile_data_offsets[tile & 0x1F] + 2 * bg_tile_line]);
+    int group;
+    for (group = 0; group < DISPLAY_WIDTH / 8; group++){
+        tile++;
+        uint32_t next_pixels = tile_row_pixels(&mem->vram[tile_data_offsets[tile & 0x1F] + 2 * bg_tile_line]);
+        line_pixels[group] = (uint16_t) (((pixels << 16) | next_pixels) >> (16 - 2 * fine_x));
+        pixels = next_pixels;
+    }
+    
+    if (window_enable && mem->wy <= mem->current_scan_line && mem->wx - 7 < DISPLAY_WIDTH){
+        int window_map_offset = window_map_area_1 ? 0x1C00 : 0x1800;
+        int windowmap_row_start = window_map_offset + (((gpu->window_ly)/8) % 32) * 32;
+        int window_tile_line = (gpu->window_ly) % 8;
+        tile_data_offsets = tile_row_data_offsets(gpu, 1, mem, windowmap_row_start, data_area_1);
+        
+        // The window starts at x = WX - 7 (-7 to 159), window_x pixels into group first_group
+        int first_group = ((mem->wx + 1) >> 3) - 1;
+        int window_x = (mem->wx + 1) & 7;
+        pixels = 0;
+        tile = 0;
+        for (group = first_group; group < DISPLAY_WIDTH / 8; group++){
+            uint32_t next_pixels = tile_row_pixels(&mem->vram[tile_data_offsets[tile++] + 2 * window_tile_line]);
+            if (group >= 0){
+                uint16_t window_pixels = (uint16_t) (((pixels << 16) | next_pixels) >> (2 * window_x));
+                // the background stays left of the window
+                uint16_t mask = group == first_group ? 0xFFFF >> (2 * window_x) : 0xFFFF;
+                line_pixels[group] = (line_pixels[group] & ~mask) | (window_pixels & mask);
+            }
+            pixels = next_pixels;
+        }
+        
+        // the window maintains its own internal ly that is only incremented when it is drawn
+        gpu->window_ly++;
+    }
+    
+    // Both buffers are word aligned, and words are stored little endian (Cortex-M3 and PC hosts)
+    uint32_t* bg_px_indx_words = (uint32_t*) gpu->line_bg_px_indx_buffer;
+    for (group = 0; group < DISPLAY_WIDTH / 8; group++){
+        uint16_t px = line_pixels[group];
+        bg_px_indx_words[0] = px_index_bytes[px >> 8];
+        bg_px_indx_words[1] = px_index_bytes[px & 0xFF];
+        bg_px_indx_words += 2;
+    }
+    write_bg_line(gpu, line_pixels);
+}
+#else
+// Draws the background and window of the current line pixel by pixel
+SRAM_CODE static void render_bg_and_window(Gpu* gpu, Memory* mem, bool bg_map_area_1, bool data_area_1, bool window_enable, bool window_map_area_1){
+    // The two background maps are located at 9800h-9BFFh and 9C00h-9FFFh
+    // Each bg map is 32x32 tiles, for a total of 256x256 pixels
+    // We can access this as either          vram[0x1800:] or vram[0x1C00:]
+    int bg_map_offset = bg_map_area_1 ? 0x1C00 : 0x1800;
+
+    // True y adjusted for scrolling
+    int bg_y = mem->current_scan_line + mem->scroll_y;
+    // Each "y" is worth 8 pixels, so divide by 8 to get num tiles
+    // Then multiply by 32 since we have 32 tiles per row
+    int bgmap_row_start = bg_map_offset + ((bg_y/8) % 32) * 32;
+    int bg_tile_line = bg_y % 8; //y % 8 gives us the specific line in the tile to show
+    const uint16_t* tile_data_offsets = tile_row_data_offsets(gpu, 0, mem, bgmap_row_start, data_area_1);
+    
+    // SCX & 7 pixels of the first tile are scrolled off the left edge,
+    // so a fine scrolled line takes pixels from 21 tiles
+    int tile = mem->scroll_x / 8;
+    int j = 7 - (mem->scroll_x & 7);   // bit of the first pixel in its tile
+    int x = 0;
+    while (x < DISPLAY_WIDTH){
+        // index at the correct 2 bytes for this row of the tile
+        const uint8_t* tile_row = &mem->vram[tile_data_offsets[tile & 0x1F] + 2 * bg_tile_line];
+        uint8_t low = tile_row[0];
+        uint8_t high = tile_row[1];
+        // Finally print the line
+        for (;j>=0 && x < DISPLAY_WIDTH;j--){
+            uint8_t pxindex = ((high >> j & 0x1) << 1) | ((low >> j) & 0x1);
+            // Save the background pixel index info for later use in sprite priority
+            gpu->line_bg_px_indx_buffer[x] = pxindex;
+            uint8_t color_index = color_index_from_pxindex(mem->background_palette, pxindex);
+            write_colorindx_to_line_buff(gpu, PALETTE_LAYER_BG, color_index, x);
+            x++;
+        }
+        j = 7;
+        tile++;
+    }
+
+    // WINDOW DRAWING
+    if (window_enable && mem->wy <= mem->current_scan_line && mem->wx - 7 < DISPLAY_WIDTH){
+        int window_map_offset = window_map_area_1 ? 0x1C00 : 0x1800;        
+        int windowmap_row_start = window_map_offset + (((gpu->window_ly)/8) % 32) * 32;
+        int window_tile_line = (gpu->window_ly) % 8;
+        tile_data_offsets = tile_row_data_offsets(gpu, 1, mem, windowmap_row_start, data_area_1);
+        
+        x = mem->wx - 7;
+        tile = 0;
+        while (x < DISPLAY_WIDTH) {
+            // index at the correct 2 bytes for this row of the tile
+            const uint8_t* tile_row = &mem->vram[tile_data_offsets[tile++] + 2 * window_tile_line];
+            uint8_t low = tile_row[0];
+            uint8_t high = tile_row[1];
+            for (j=7;j>=0;j--){
+                if (x >= 0 && x < DISPLAY_WIDTH) {
+                    int8_t pxindex = ((high >> j & 0x1) << 1) | ((low >> j) & 0x1);
+                    // Save the background pixel index info for later use in sprite priority
+                    gpu->line_bg_px_indx_buffer[x] = pxindex;
+                    // finally draw the pixel
+                    uint8_t color_index = color_index_from_pxindex(mem->background_palette, pxindex);
+                    write_colorindx_to_line_buff(gpu, PALETTE_LAYER_BG, color_index, x);    
+                    
+                }
+                x++;   
+            }
+        }
+
+        // the window maintains its own internal ly that is only incremented when it is drawn
+        gpu->window_ly++;
+    }
 }
+#endif
 
-void renderLine(Gpu* gpu, Memory* mem){
+//Called at the end of every PIXEL_TRANSFER_MODE
+// Renders the current line
+SRAM_CODE void renderLine(Gpu* gpu, Memory* mem){
     
     bool lcd_enable = (mem->lcdc &          0b10000000) != 0; // 7 LCD and PPU enable 	0=Off, 1=On
     bool window_map_area_1 = (mem->lcdc &   0b01000000) != 0; // Window tile map area 	0=9800-9BFF, 1=9C00-9FFF
@@ -162,94 +486,20 @@ void renderLine(Gpu* gpu, Memory* mem){
     
     if (!lcd_enable) return;
     
-    // wait until we can modify the line buffer
-    while (!isDmaReady()){};
+    if (gpu->sink == FRAME_SINK_BUFFER){
+        // render straight into this line of the framebuffer
+        gpu->line_buffer = &gpu->framebuffer[mem->current_scan_line * SCALED(DISPLAY_WIDTH, gpu->output_scale) * 2];
+    } else {
+        // wait until we can modify the line buffer
+        wait_for_dma(gpu);
+    }
+#if WORD_PIXEL_WRITES_ON
+    update_palette_colors(gpu, mem);
+#endif
     
     // BACKGROUND AND WINDOW
     if (bg_window_enable){
-        // The two background maps are located at 9800h-9BFFh and 9C00h-9FFFh
-        // Each bg map is 32x32 tiles, for a total of 256x256 pixels
-        // We can access this as either          vram[0x1800:] or vram[0x1C00:]
-        int bg_map_offset = bg_map_area_1 ? 0x1C00 : 0x1800;
-
-        // True y adjusted for scrolling
-        int bg_y = mem->current_scan_line + mem->scroll_y;
-        // Each "y" is worth 8 pixels, so divide by 8 to get num tiles
-        // Then multiply by 32 since we have 32 tiles per row
-        int bgmap_row_start = bg_map_offset + ((bg_y/8) % 32) * 32;
-        int bg_tile_line = bg_y % 8; //y % 8 gives us the specific line in the tile to show
-     
-        
-        int i;
-        int x = 0;
-        for (i=0;i<DISPLAY_WIDTH/8;i++){    //DISPLAY_WIDTH/8 = 20 total tiles on the line
-            // Which tile are we on?
-            uint8_t tile_id_u8 = mem->vram[bgmap_row_start + ((i + mem->scroll_x/8) & 0x1F)];
-            int tile_id = (int32_t) tile_id_u8;
-            if (!data_area_1){ //bit 4 in LCDC specifies whether or not to use 0x8000 base addr unsigned
-                // when bit 4 is low, 9000 is the base pointer and the index is signed
-                if (tile_id < 128) tile_id  += 256;
-            }
-           
-
-            int tile_start_addr = tile_id * 16; //each tile is 16 bytes            
-            // finally index at the correct 2 bytes for this row
-            uint8_t low = mem->vram[tile_start_addr + 2 * bg_tile_line];  
-            uint8_t high = mem->vram[tile_start_addr + 2 * bg_tile_line + 1];
-            // Finally print the line
-            int j;
-            for (j=7;j>=0;j--){
-                uint8_t pxindex = ((high >> j & 0x1) << 1) | ((low >> j) & 0x1);
-                // Save the background pixel index info for later use in sprite priority
-                gpu->line_bg_px_indx_buffer[x] = pxindex;
-                uint8_t color_index = color_index_from_pxindex(mem->background_palette, pxindex);
-                write_colorindx_to_dma_buff(color_index, x);
-                x++;   
-            }
-        }
-        
-        // WINDOW DRAWING
-        if (window_enable && mem->wy <= mem->current_scan_line && mem->wx - 7 < DISPLAY_WIDTH){
-            int window_map_offset = window_map_area_1 ? 0x1C00 : 0x1800;        
-            int windowmap_row_start = window_map_offset + (((gpu->window_ly)/8) % 32) * 32;
-            int window_tile_line = (gpu->window_ly) % 8;
-      
-            
-       
-            x = mem->wx - 7;
-           
-            while (x < DISPLAY_WIDTH) {
-                // Which tile are we on?
-                uint8_t tile_id_u8 = mem->vram[windowmap_row_start + ((x - (mem->wx - 7))/8)];
-                int tile_id = (int32_t) tile_id_u8;
-                if (!data_area_1){ //bit 4 in LCDC specifies whether or not to use 0x8000 base addr unsigned
-                    // when bit 4 is low, 9000 is the base pointer and the index is signed
-                    if (tile_id < 128) tile_id  += 256;
-                }
-               
-
-                int tile_start_addr = tile_id * 16; //each tile is 16 bytes            
-                // finally index at the correct 2 bytes for this row
-                uint8_t low = mem->vram[tile_start_addr + 2 * window_tile_line];  
-                uint8_t high = mem->vram[tile_start_addr + 2 * window_tile_line + 1];
-                int j;
-                for (j=7;j>=0;j--){
-                    if (x >= 0 && x < DISPLAY_WIDTH) {
-                        int8_t pxindex = ((high >> j & 0x1) << 1) | ((low >> j) & 0x1);
-                        // Save the background pixel index info for later use in sprite priority
-                        gpu->line_bg_px_indx_buffer[x] = pxindex;
-                        // finally draw the pixel
-                        uint8_t color_index = color_index_from_pxindex(mem->background_palette, pxindex);
-                        write_colorindx_to_dma_buff(color_index, x);    
-                        
-                    }
-                    x++;   
-                }
-            }
-
-            // the window maintains its own internal ly that is only incremented when it is drawn
-            gpu->window_ly++;
-        }
+        render_bg_and_window(gpu, mem, bg_map_area_1, data_area_1, window_enable, window_map_area_1);
     }
  
     
@@ -260,35 +510,48 @@ void renderLine(Gpu* gpu, Memory* mem){
         // (valid x and y)
         int sprite_display_count = 0;
         int sprite_num;
-        for (sprite_num=0;sprite_num<40;sprite_num++){
+        for (sprite_num=0;sprite_num<OAM_SPRITE_COUNT;sprite_num++){
             int sprite_offset = sprite_num * 4; //4 bytes per sprite
             int sprite_y = (int) mem->oam[sprite_offset] - 16;     // first byte is y  + 16
             int sprite_x = (int) mem->oam[sprite_offset + 1] - 8; //second byte is x + 8
-            sprite_nums_to_x_coord[sprite_num] = sprite_x;
+            gpu->sprite_nums_to_x_coord[sprite_num] = sprite_x;
             // Only render sprites that lie on the scan line
             if (sprite_y <= mem->current_scan_line && (sprite_y + (obj_size8x16 ? 16 : 8)) > mem->current_scan_line){
-                sprite_nums_to_display[sprite_display_count] = sprite_num;
+                gpu->sprite_nums_to_display[sprite_display_count] = sprite_num;
                 sprite_display_count++;
-                if (sprite_display_count >= 10) break;         // can only draw 10 sprites per line       
+                if (sprite_display_count >= MAX_SPRITES_PER_LINE) break;         // can only draw 10 sprites per line       
             }
         }
         
         // Sort the sprite nums in order of increasing x value (priority)
-        qsort(sprite_nums_to_display, sprite_display_count, sizeof(int), compare_sprite_nums_priority);
+        sort_sprites_by_priority(gpu, sprite_display_count);
         
         int i;
         for (i = 0; i < sprite_display_count; i++){
-            render_sprite_on_scanline(gpu, mem, sprite_nums_to_display[i], obj_size8x16);   
+            render_sprite_on_scanline(gpu, mem, gpu->sprite_nums_to_display[i], obj_size8x16);   
         }
         
     }
 
     
     // Finally send the line buffer over SPI
-    startDmaTransfer();
+    if (gpu->sink == FRAME_SINK_SPI_DMA){
+        startDmaTransfer(scaled_line_sends(gpu->output_scale, mem->current_scan_line));
+    }
 }
 
 
+int gpu_cycles_to_event(Gpu* gpu){
+    static const uint8_t mode_times[4] = {
+        [HBLANK_MODE] = HBLANK_TIME_MACHINE_CYCLES,
+        [VBLANK_MODE] = ONE_LINE_TIME_MACHINE_CYCLES,
+        [OAM_MODE] = OAM_READ_TIME_MACHINE_CYCLES,
+        [PIXEL_TRANSFER_MODE] = VRAM_READ_TIME_MACHINE_CYCLES,
+    };
+    int cycles = mode_times[gpu->mode] - (int) gpu->mode_clock;
+    return cycles > 0 ? cycles : 1;
+}
+
 void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles){
     // TODO Check LCDC register
     Memory* mem = gpu->mem;
@@ -322,8 +585,15 @@ void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles){
             gpu->mode = HBLANK_MODE;
             
             //Draw a full line
-            if (!DEBUG_MODE)
-                renderLine(gpu, mem);
+            if (gpu->sink != FRAME_SINK_NULL){
+                if (SUBSYSTEM_TIMING_ON && gpu->perf){
+                    PerfTicks start = perf_now();
+                    renderLine(gpu, mem);
+                    perf_add_since(gpu->perf, PERF_RENDER, start);
+                } else {
+                    renderLine(gpu, mem);
+                }
+            }
         }
         break;
         // HBlank
@@ -337,7 +607,7 @@ void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles){
             if (mem->current_scan_line == mem->lyc){
                 // Check for LY==LYC interrupts
                 if(mem->lcdstatus & LCD_STAT_LY_LYC_INTERRUPT_REG_MASK){
-                    mem->interrupt_flag |= INTERRUPT_ENABLE_STAT_MASK;
+                    request_interrupt(mem, INTERRUPT_ENABLE_STAT_MASK);
                 }
                 mem->lcdstatus |= LCD_STAT_LY_LYC_EQ_REG_MASK;
             } else {
@@ -349,8 +619,10 @@ void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles){
                 
                 // change to vblank
                 gpu->mode = VBLANK_MODE;
+                gpu->frame_count++;
+                if (gpu->vblank_hook) gpu->vblank_hook(gpu->vblank_hook_ctx);
                 // request interrupt
-                mem->interrupt_flag |= INTERRUPT_ENABLE_VBLANK_MASK;
+                request_interrupt(mem, INTERRUPT_ENABLE_VBLANK_MASK);
             }else{
                 gpu->mode = OAM_MODE;
             }
@@ -368,8 +640,8 @@ void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles){
                 mem->current_scan_line = 0;
                 gpu->window_ly = 0;
                 
-                if (!DEBUG_MODE){
-                    while (!isDmaReady()){};            // wait for DMA stuff to finish
+                if (gpu->sink == FRAME_SINK_SPI_DMA){
+                    wait_for_dma(gpu);                  // wait for DMA stuff to finish
                     write8_a0(0x00);                    // send NOP command to end the last writing process
                     write8_a0(0x2C);                    // send Memory Write command to start a new one
                     setDChigh();                        // set DC line high to start sending data instead of cmds
@@ -1,25 +1,109 @@
 #ifndef Gpu_H
 #define Gpu_H
 #include "memory.h"
+#include "perfstats.h"
+#include "palette.h"
+#include "emumode.h"
+#include "arena.h"
 #include "stdint.h"    
 #define DISPLAY_WIDTH 160
 #define DISPLAY_HEIGHT 144
+// Output scales, counted in halves so 1.5x stays an integer
+// Pixels are widened as the line is written out and lines are repeated by the SPI DMA,
+// so scaling up only costs SPI time
+#define OUTPUT_SCALE_1X 2
+#define OUTPUT_SCALE_1_5X 3             // nearest neighbour: every other pixel and line is doubled
+#define OUTPUT_SCALE_2X 4
+#define SCALED(n, scale) ((n) * (scale) / 2)
+// Each pixel is 2 bytes => 160 * 2 = 320 at OUTPUT_SCALE_1X
+#define LINE_SPI_DMA_BUFFER_SIZE (SCALED(DISPLAY_WIDTH, OUTPUT_SCALE) * 2)
+#define MAX_SPRITES_PER_LINE 10
+#define OAM_SPRITE_COUNT 40
+
+// Where renderLine sends finished lines
+typedef enum FrameSink {
+    FRAME_SINK_SPI_DMA,  // stream each line to the TFT through the SPI DMA line buffer
+    FRAME_SINK_BUFFER,   // render straight into an in-memory DISPLAY_WIDTH x DISPLAY_HEIGHT framebuffer
+    FRAME_SINK_NULL      // don't render at all (emulation only)
+} FrameSink;
+
+#define TILE_MAP_WIDTH 32               // tiles per tile map row
+#define TILE_MAP_ROWS 64                // rows of both tile maps together (0x9800-0x9FFF)
+
+// Where the tile data of each tile in one tile map row starts in vram
+// A row covers 8 lines, so this is only redone when the row, the tile data area (LCDC bit 4) or
+// the tile map itself changes, instead of for every tile of every line
+typedef struct TileRowCache {
+    uint16_t tile_data_offsets[TILE_MAP_WIDTH];
+    int map_row_start;       // vram offset of the row in its tile map (covers LCDC bits 3 and 6), -1 when empty
+    bool data_area_1;
+    uint32_t tile_map_writes;  // mem->tile_map_writes when it was filled
+} TileRowCache;
 
-extern const uint16_t COLORS[4]; 
 typedef struct Gpu {
     Memory* mem;
     uint32_t mode_clock;
     uint8_t mode;       // current mode of the CPU; 0 1 2 or 3
     // holds background data for current scanline; used for sprite priority
-    uint8_t line_bg_px_indx_buffer[DISPLAY_WIDTH];  
+    // (word aligned, like the line buffers, for WORD_PIXEL_WRITES_ON)
+    uint8_t line_bg_px_indx_buffer[DISPLAY_WIDTH] __attribute__((aligned(4)));
     uint8_t window_ly;  // the window maintains its own internal ly that is only incremented when it is displayd
+    uint8_t line_spi_dma_buffer[LINE_SPI_DMA_BUFFER_SIZE] __attribute__((aligned(4)));   // dma data transfer buffer
+    // the following arrays are used to sort sprites (handles priority)
+    int sprite_nums_to_display[MAX_SPRITES_PER_LINE];  // used to hold sprites for sorting
+    int sprite_nums_to_x_coord[OAM_SPRITE_COUNT];
+    FrameSink sink;
+    // FRAME_SINK_BUFFER only: DISPLAY_WIDTH * DISPLAY_HEIGHT pixels, 2 bytes each, same format as the line buffer
+    uint8_t* framebuffer;
+    uint8_t* line_buffer;   // where the current line is rendered to
+    uint8_t output_scale;   // OUTPUT_SCALE_* the line buffer is written at
+    unsigned long frame_count;  // number of frames completed (incremented on entering vblank)
+    // row_cache_count caches for the background, then as many for the window, from the arena (alloc_tile_row_caches)
+    // a tile map row uses cache (row & (row_cache_count - 1)) of its layer
+    TileRowCache* row_caches;
+    int row_cache_count;
+    // selected palette of each layer, as stored in the line buffer (RGB565 with its bytes swapped, see gpu.c)
+    uint16_t layer_colors[PALETTE_LAYER_COUNT][4];
+    // WORD_PIXEL_WRITES_ON only: layer_colors through the current palette registers
+    uint32_t bg_pixel_pair_colors[16];  // two pixels per entry, indexed by (first pixel index << 2) | second pixel index
+    uint16_t obj_colors[2][4];          // OBP0 and OBP1, indexed by pixel index
+    uint16_t bg_colors[4];              // indexed by pixel index
+    uint16_t bgp_built;                 // BGP value bg_pixel_pair_colors and bg_colors were made for, 0x100 for none
+    uint16_t obp_built[2];
+    PerfStats* perf;            // only used when SUBSYSTEM_TIMING_ON; NULL disables timing
+    void (*vblank_hook)(void* ctx);  // called on entering vblank, NULL for none
+    void* vblank_hook_ctx;
 } Gpu;
 // Initializes GPU
+// Renders to the TFT over SPI DMA by default, or nowhere in DEBUG_MODE, in the DEFAULT_PALETTE preset
 void setup_gpu(Gpu* gpu, Memory* mem);
+// Takes the tile row caches from the arena: one per layer at least, and up to one per tile map row
+// while more fit in what is free beyond keep_free bytes
+// Returns false when not even the first two fit; the gpu must not render then
+bool alloc_tile_row_caches(Gpu* gpu, Arena* arena, uint32_t keep_free);
+// Selects where rendered lines go
+// framebuffer is only used by FRAME_SINK_BUFFER and must hold DISPLAY_WIDTH * DISPLAY_HEIGHT * 2 bytes, word aligned
+// The SPI DMA sink is written at OUTPUT_SCALE, the others at OUTPUT_SCALE_1X
+void set_frame_sink(Gpu* gpu, FrameSink sink, uint8_t* framebuffer);
+// Writes the framebuffer of FRAME_SINK_BUFFER at another scale, to measure it off the PSoC
+// It then needs SCALED(DISPLAY_WIDTH, scale) * 2 bytes per line; lines are not repeated
+void set_output_scale(Gpu* gpu, uint8_t scale);
+// How many times line ly is sent to the TFT at scale
+static inline int scaled_line_sends(uint8_t scale, int ly){
+    if (scale == OUTPUT_SCALE_2X) return 2;
+    if (scale == OUTPUT_SCALE_1_5X) return 2 - (ly & 1);
+    return 1;
+}
+// Draws layer in palette from now on
+void set_layer_palette(Gpu* gpu, PaletteLayer layer, const Palette* palette);
+// Draws every layer in one of the palette presets from now on
+void set_palette_preset(Gpu* gpu, PalettePreset preset);
 // processes the next tick of the GPU
 // Takes in the # of machine cycles that elapsed
 void tick_gpu(Gpu* gpu, uint8_t delta_machine_cycles);
+// Machine cycles until the next mode change, the soonest tick_gpu can change anything the cpu sees
+int gpu_cycles_to_event(Gpu* gpu);
 // Renders the current line at mem->current_scan_line
-void renderLine(Gpu* gpu, Memory* mem);
+SRAM_CODE void renderLine(Gpu* gpu, Memory* mem);
 
 #endif
\ No newline at end of file
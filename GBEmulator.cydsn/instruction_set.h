@@ -4,6 +4,8 @@
 #include "stdint.h"
 #include "memory.h"
 #include "rom.h"
+#include "emumode.h"
+#include "alu_tables.h"
     
 typedef enum CC {
     Z, NZ, C, NC
@@ -11,18 +13,15 @@ typedef enum CC {
 
 static inline void increment_pc(Cpu* cpu){
     cpu->reg.pc++;
-    if (cpu->reg.pc == BIOS_SIZE && cpu->inBios) {
-        cpu->inBios = false;
-    }
 }
 
 static inline void push_stack_u8(Cpu* cpu, uint8_t value){
     cpu->reg.sp--;
-    write_mem(cpu->mem, cpu->reg.sp, value);
+    write_ram(cpu->mem, cpu->reg.sp, value);
 } 
 
 static inline uint8_t pop_stack_u8(Cpu* cpu){
-    uint8_t result = fetch(cpu->mem, cpu->reg.sp, cpu->inBios);
+    uint8_t result = fetch_ram(cpu->mem, cpu->reg.sp, CPU_IN_BIOS(cpu));
     cpu->reg.sp++;
     return result;
 }
@@ -96,7 +95,7 @@ static inline void add_to_sp(Cpu* cpu, int8_t offset){
 }
 
 static inline uint8_t fetch_and_increment_pc(Cpu* cpu){
-    uint8_t data = fetch(cpu->mem, cpu->reg.pc, cpu->inBios);
+    uint8_t data = fetch(cpu->mem, cpu->reg.pc, CPU_IN_BIOS(cpu));
     increment_pc(cpu);
     return data;
 }
@@ -108,13 +107,28 @@ static inline uint16_t fetch_and_increment_pc_twice(Cpu* cpu){
 }
 
 
+#if ALU_LOOKUP_TABLES_ON
+// Flags of an 8 bit add/subtract from its untruncated result: H is the carry into bit 4,
+// C the carry (or borrow) into bit 8. Replaces four read-modify-writes of F with one
+static inline void set_arithmetic_flags(Cpu* cpu, unsigned int a, unsigned int b, unsigned int result, uint8_t n_flag){
+    cpu->reg.f = (cpu->reg.f & FLAG_UNUSED) | zero_flag_table[result & 0xFF] | n_flag |
+        (((a ^ b ^ result) & 0x10) << 1) | ((result >> 4) & FLAG_C);
+}
+#endif
+
 static inline void adc_a_b(Cpu* cpu, uint8_t b){
+#if ALU_LOOKUP_TABLES_ON
+    unsigned int result = cpu->reg.a + b + get_carry_flag(&cpu->reg);
+    set_arithmetic_flags(cpu, cpu->reg.a, b, result, 0);
+    cpu->reg.a = result;
+#else
     int init_carry = get_carry_flag(&cpu->reg);
     set_subtraction_flag(&cpu->reg, false);
     set_half_carry_flag(&cpu->reg, ((cpu->reg.a & 0XF)+ (b & 0XF) + get_carry_flag(&cpu->reg)) > 0XF);
     set_carry_flag(&cpu->reg, (cpu->reg.a + b + get_carry_flag(&cpu->reg)) > 0xFF);
     cpu->reg.a += b + init_carry;
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
+#endif
 }
 
 static inline uint8_t adc_a_r8(Cpu* cpu, uint8_t* reg){
@@ -122,7 +136,7 @@ static inline uint8_t adc_a_r8(Cpu* cpu, uint8_t* reg){
     return 1;
 }
 static inline uint8_t adc_a_mhl(Cpu* cpu){
-    adc_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    adc_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t adc_a_n8(Cpu* cpu){
@@ -131,18 +145,24 @@ static inline uint8_t adc_a_n8(Cpu* cpu){
 }
 
 static inline void add_a_b(Cpu* cpu, uint8_t b){
+#if ALU_LOOKUP_TABLES_ON
+    unsigned int result = cpu->reg.a + b;
+    set_arithmetic_flags(cpu, cpu->reg.a, b, result, 0);
+    cpu->reg.a = result;
+#else
     set_subtraction_flag(&cpu->reg, false);
     set_carry_flag(&cpu->reg, carry_on_addition_u8(cpu->reg.a, b));
     set_half_carry_flag(&cpu->reg, half_carry_addition_u8(cpu->reg.a, b));
     cpu->reg.a += b;
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
+#endif
 }
 static inline uint8_t add_a_r8(Cpu* cpu, uint8_t* reg){
     add_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t add_a_mhl(Cpu* cpu){
-    add_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    add_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t add_a_n8(Cpu* cpu){
@@ -151,17 +171,21 @@ static inline uint8_t add_a_n8(Cpu* cpu){
 }
 static inline void and_a_b(Cpu* cpu, uint8_t b){
     cpu->reg.a &= b;
+#if ALU_LOOKUP_TABLES_ON
+    cpu->reg.f = (cpu->reg.f & FLAG_UNUSED) | zero_flag_table[cpu->reg.a] | FLAG_H;
+#else
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
     set_subtraction_flag(&cpu->reg, false);
     set_half_carry_flag(&cpu->reg, true);
     set_carry_flag(&cpu->reg, false);
+#endif
 }
 static inline uint8_t and_a_r8(Cpu* cpu, uint8_t* reg){
     and_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t and_a_mhl(Cpu* cpu){
-    and_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    and_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t and_a_n8(Cpu* cpu){
@@ -169,17 +193,21 @@ static inline uint8_t and_a_n8(Cpu* cpu){
     return 2;
 }
 static inline void cp_a_b(Cpu* cpu, uint8_t b){
+#if ALU_LOOKUP_TABLES_ON
+    set_arithmetic_flags(cpu, cpu->reg.a, b, cpu->reg.a - b, FLAG_N);
+#else
     set_zero_flag(&cpu->reg, cpu->reg.a == b);
     set_subtraction_flag(&cpu->reg, true);
     set_half_carry_flag(&cpu->reg, (b & 0x0f) > (cpu->reg.a & 0x0f));  
     set_carry_flag(&cpu->reg, b > cpu->reg.a);
+#endif
 }
 static inline uint8_t cp_a_r8(Cpu* cpu, uint8_t* reg){
     cp_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t cp_a_mhl(Cpu* cpu){
-    cp_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    cp_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t cp_a_n8(Cpu* cpu){
@@ -187,50 +215,66 @@ static inline uint8_t cp_a_n8(Cpu* cpu){
     return 2;
 }
 static inline uint8_t dec_u8(Cpu* cpu, uint8_t num){
+#if ALU_LOOKUP_TABLES_ON
+    num -= 1;
+    cpu->reg.f = (cpu->reg.f & (FLAG_C | FLAG_UNUSED)) | dec_flag_table[num];
+    return num;
+#else
     set_half_carry_flag(&cpu->reg, (num & 0x0F) == 0x00);
     num -= 1;
     set_zero_flag(&cpu->reg, num == 0);
     set_subtraction_flag(&cpu->reg, true);
     return num;
+#endif
 }
 static inline uint8_t dec_r8(Cpu* cpu, uint8_t* reg){
     *reg = dec_u8(cpu, *reg);
     return 1;
 }
 static inline uint8_t dec_mhl(Cpu* cpu){
-    uint8_t num = fetch(cpu->mem, cpu->reg.hl, cpu->inBios);
-    write_mem(cpu->mem, cpu->reg.hl, dec_u8(cpu, num));
+    uint8_t num = fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu));
+    write_ram(cpu->mem, cpu->reg.hl, dec_u8(cpu, num));
     return 3;
 }
 static inline uint8_t inc_u8(Cpu* cpu, uint8_t num){
+#if ALU_LOOKUP_TABLES_ON
+    num += 1;
+    cpu->reg.f = (cpu->reg.f & (FLAG_C | FLAG_UNUSED)) | inc_flag_table[num];
+    return num;
+#else
     set_half_carry_flag(&cpu->reg, (num & 0x0F) == 0xF);
     num += 1;
     set_zero_flag(&cpu->reg, num == 0);
     set_subtraction_flag(&cpu->reg, false);
     return num;
+#endif
 }
 static inline uint8_t inc_r8(Cpu* cpu, uint8_t* reg){
     *reg = inc_u8(cpu, *reg);
     return 1;
 }
 static inline uint8_t inc_mhl(Cpu* cpu){
-    uint8_t num = fetch(cpu->mem, cpu->reg.hl, cpu->inBios);
-    write_mem(cpu->mem, cpu->reg.hl, inc_u8(cpu, num));
+    uint8_t num = fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu));
+    write_ram(cpu->mem, cpu->reg.hl, inc_u8(cpu, num));
     return 3;
 }
 static inline void or_a_b(Cpu* cpu, uint8_t b){
     cpu->reg.a |= b;
+#if ALU_LOOKUP_TABLES_ON
+    cpu->reg.f = (cpu->reg.f & FLAG_UNUSED) | zero_flag_table[cpu->reg.a];
+#else
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
     set_subtraction_flag(&cpu->reg, false);
     set_half_carry_flag(&cpu->reg, false);
     set_carry_flag(&cpu->reg, false);
+#endif
 }
 static inline uint8_t or_a_r8(Cpu* cpu, uint8_t* reg){
     or_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t or_a_mhl(Cpu* cpu){
-    or_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    or_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t or_a_n8(Cpu* cpu){
@@ -238,19 +282,25 @@ static inline uint8_t or_a_n8(Cpu* cpu){
     return 2;
 }
 static inline void sbc_a_b(Cpu* cpu, uint8_t b){
+#if ALU_LOOKUP_TABLES_ON
+    unsigned int result = cpu->reg.a - b - get_carry_flag(&cpu->reg);
+    set_arithmetic_flags(cpu, cpu->reg.a, b, result, FLAG_N);
+    cpu->reg.a = result;
+#else
     int init_carry = get_carry_flag(&cpu->reg);
     set_subtraction_flag(&cpu->reg, true);
     set_half_carry_flag(&cpu->reg, (b & 0x0f) + init_carry > (cpu->reg.a & 0x0f));
     set_carry_flag(&cpu->reg, (b + init_carry) > cpu->reg.a);
     cpu->reg.a -= b + init_carry;
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
+#endif
 }
 static inline uint8_t sbc_a_r8(Cpu* cpu, uint8_t* reg){
     sbc_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t sbc_a_mhl(Cpu* cpu){
-    sbc_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    sbc_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t sbc_a_n8(Cpu* cpu){
@@ -258,18 +308,24 @@ static inline uint8_t sbc_a_n8(Cpu* cpu){
     return 2;
 }
 static inline void sub_a_b(Cpu* cpu, uint8_t b){
+#if ALU_LOOKUP_TABLES_ON
+    unsigned int result = cpu->reg.a - b;
+    set_arithmetic_flags(cpu, cpu->reg.a, b, result, FLAG_N);
+    cpu->reg.a = result;
+#else
     set_subtraction_flag(&cpu->reg, true);
     set_half_carry_flag(&cpu->reg, half_carry_subtration_u8(cpu->reg.a, b));
     set_carry_flag(&cpu->reg, carry_on_subtraction_u8(cpu->reg.a, b));
     cpu->reg.a -= b;
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
+#endif
 }
 static inline uint8_t sub_a_r8(Cpu* cpu, uint8_t* reg){
     sub_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t sub_a_mhl(Cpu* cpu){
-    sub_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    sub_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t sub_a_n8(Cpu* cpu){
@@ -278,17 +334,21 @@ static inline uint8_t sub_a_n8(Cpu* cpu){
 }
 static inline void xor_a_b(Cpu* cpu, uint8_t b){
     cpu->reg.a ^= b;
+#if ALU_LOOKUP_TABLES_ON
+    cpu->reg.f = (cpu->reg.f & FLAG_UNUSED) | zero_flag_table[cpu->reg.a];
+#else
     set_zero_flag(&cpu->reg, cpu->reg.a == 0);
     set_subtraction_flag(&cpu->reg, false);
     set_carry_flag(&cpu->reg, false);
     set_half_carry_flag(&cpu->reg, false);
+#endif
 }
 static inline uint8_t xor_a_r8(Cpu* cpu, uint8_t* reg){
     xor_a_b(cpu, *reg);
     return 1;
 }
 static inline uint8_t xor_a_mhl(Cpu* cpu){
-    xor_a_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    xor_a_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 2;
 }
 static inline uint8_t xor_a_n8(Cpu* cpu){
@@ -327,7 +387,7 @@ static inline uint8_t bit_u3_r8(Cpu* cpu, uint8_t position, uint8_t* reg){
     return 2;
 }
 static inline uint8_t bit_u3_mhl(Cpu* cpu, uint8_t position){
-    bit_u3_b(cpu, position, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
+    bit_u3_b(cpu, position, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
     return 3;
 }
 // returns the new value
@@ -339,8 +399,8 @@ static inline uint8_t res_u3_r8(Cpu* cpu, uint8_t position, uint8_t* reg){
     return 2;
 }
 static inline uint8_t res_u3_mhl(Cpu* cpu, uint8_t position){
-    uint8_t new_val = res_u3_b(cpu, position, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = res_u3_b(cpu, position, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 // Returns the new value
@@ -352,8 +412,8 @@ static inline uint8_t set_u3_r8(Cpu* cpu, uint8_t position, uint8_t* reg){
     return 2;
 }
 static inline uint8_t set_u3_mhl(Cpu* cpu, uint8_t position){
-    uint8_t new_val = set_u3_b(cpu, position, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = set_u3_b(cpu, position, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 // Returns new value
@@ -372,8 +432,8 @@ static inline uint8_t swap_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t swap_mhl(Cpu* cpu){
-    uint8_t new_val = swap_nibbles(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = swap_nibbles(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t rl_b(Cpu* cpu, uint8_t b){
@@ -390,8 +450,8 @@ static inline uint8_t rl_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t rl_mhl(Cpu* cpu){
-    uint8_t new_val = rl_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = rl_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t rla(Cpu* cpu){
@@ -416,8 +476,8 @@ static inline uint8_t rlc_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t rlc_mhl(Cpu* cpu){
-    uint8_t new_val = rlc_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = rlc_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t rlca(Cpu* cpu){
@@ -442,8 +502,8 @@ static inline uint8_t rr_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t rr_mhl(Cpu* cpu){
-    uint8_t new_val = rr_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = rr_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t rra(Cpu* cpu){
@@ -468,8 +528,8 @@ static inline uint8_t rrc_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t rrc_mhl(Cpu* cpu){
-    uint8_t new_val = rrc_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = rrc_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t rrca(Cpu* cpu){
@@ -498,8 +558,8 @@ static inline uint8_t sla_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t sla_mhl(Cpu* cpu){
-    uint8_t new_val = sla_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = sla_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t sra_b(Cpu* cpu, uint8_t b){
@@ -515,8 +575,8 @@ static inline uint8_t sra_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t sra_mhl(Cpu* cpu){
-    uint8_t new_val = sra_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = sra_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t srl_b(Cpu* cpu, uint8_t b){
@@ -532,8 +592,8 @@ static inline uint8_t srl_r8(Cpu* cpu, uint8_t* reg){
     return 2;
 }
 static inline uint8_t srl_mhl(Cpu* cpu){
-    uint8_t new_val = srl_b(cpu, fetch(cpu->mem, cpu->reg.hl, cpu->inBios));
-    write_mem(cpu->mem, cpu->reg.hl, new_val);
+    uint8_t new_val = srl_b(cpu, fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu)));
+    write_ram(cpu->mem, cpu->reg.hl, new_val);
     return 4;
 }
 static inline uint8_t ld_r8_r8(Cpu* cpu, uint8_t* a, uint8_t* b){
@@ -549,19 +609,19 @@ static inline uint8_t ld_r16_n16(Cpu* cpu, uint16_t* reg){
     return 3;
 }
 static inline uint8_t ld_mhl_r8(Cpu* cpu, uint8_t* reg){
-    write_mem(cpu->mem, cpu->reg.hl, *reg);
+    write_ram(cpu->mem, cpu->reg.hl, *reg);
     return 2;
 }
 static inline uint8_t ld_mhl_n8(Cpu* cpu){
-    write_mem(cpu->mem, cpu->reg.hl, fetch_and_increment_pc(cpu));
+    write_ram(cpu->mem, cpu->reg.hl, fetch_and_increment_pc(cpu));
     return 3;
 }
 static inline uint8_t ld_r8_mhl(Cpu* cpu, uint8_t* reg){
-    *reg = fetch(cpu->mem, cpu->reg.hl, cpu->inBios);
+    *reg = fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu));
     return 2;
 }
 static inline uint8_t ld_mr16_a(Cpu* cpu, uint16_t* reg){
-    write_mem(cpu->mem, *reg, cpu->reg.a);
+    write_ram(cpu->mem, *reg, cpu->reg.a);
     return 2;
 }
 static inline uint8_t ld_mn16_a(Cpu* cpu){
@@ -569,46 +629,46 @@ static inline uint8_t ld_mn16_a(Cpu* cpu){
     return 4;
 }
 static inline uint8_t ldh_mn16_a(Cpu* cpu){
-    write_mem(cpu->mem, 0xFF00 + fetch_and_increment_pc(cpu), cpu->reg.a);
+    write_high(cpu->mem, fetch_and_increment_pc(cpu), cpu->reg.a);
     return 3;
 }
 static inline uint8_t ldh_mc_a(Cpu* cpu){
-    write_mem(cpu->mem, 0xFF00 + cpu->reg.c, cpu->reg.a);
+    write_high(cpu->mem, cpu->reg.c, cpu->reg.a);
     return 2;
 }
 static inline uint8_t ld_a_mr16(Cpu* cpu, uint16_t* reg){
-    cpu->reg.a = fetch(cpu->mem, *reg, cpu->inBios);
+    cpu->reg.a = fetch_ram(cpu->mem, *reg, CPU_IN_BIOS(cpu));
     return 2;
 }
 static inline uint8_t ld_a_mn16(Cpu* cpu){
-    cpu->reg.a = fetch(cpu->mem, fetch_and_increment_pc_twice(cpu), cpu->inBios);
+    cpu->reg.a = fetch(cpu->mem, fetch_and_increment_pc_twice(cpu), CPU_IN_BIOS(cpu));
     return 4;
 }
 static inline uint8_t ldh_a_mn16(Cpu* cpu){
-    cpu->reg.a = fetch(cpu->mem, 0xFF00 + fetch_and_increment_pc(cpu), cpu->inBios);
+    cpu->reg.a = fetch_high(cpu->mem, fetch_and_increment_pc(cpu));
     return 3;
 }
 static inline uint8_t ldh_a_mc(Cpu* cpu){
-    cpu->reg.a = fetch(cpu->mem, 0xFF00 + cpu->reg.c, cpu->inBios);
+    cpu->reg.a = fetch_high(cpu->mem, cpu->reg.c);
     return 2;
 }
 static inline uint8_t ld_mhli_a(Cpu* cpu){
-    write_mem(cpu->mem, cpu->reg.hl, cpu->reg.a);
+    write_ram(cpu->mem, cpu->reg.hl, cpu->reg.a);
     cpu->reg.hl++;
     return 2;
 }
 static inline uint8_t ld_mhld_a(Cpu* cpu){
-    write_mem(cpu->mem, cpu->reg.hl, cpu->reg.a);
+    write_ram(cpu->mem, cpu->reg.hl, cpu->reg.a);
     cpu->reg.hl--;
     return 2;
 }
 static inline uint8_t ld_a_mhli(Cpu* cpu){
-    cpu->reg.a = fetch(cpu->mem, cpu->reg.hl, cpu->inBios);
+    cpu->reg.a = fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu));
     cpu->reg.hl++;
     return 2;
 }
 static inline uint8_t ld_a_mhld(Cpu* cpu){
-    cpu->reg.a = fetch(cpu->mem, cpu->reg.hl, cpu->inBios);
+    cpu->reg.a = fetch_ram(cpu->mem, cpu->reg.hl, CPU_IN_BIOS(cpu));
     cpu->reg.hl--;
     return 2;
 }
@@ -711,8 +771,17 @@ static inline uint8_t ret_cc(Cpu* cpu, CC cc){
     return 2;
 }
 
+// Sets IME, keeping mem->interrupt_check in step
+// Any EI still waiting to take effect is overridden
+static inline void set_ime(Cpu* cpu, bool ime){
+    cpu->reg.ime = ime;
+    cpu->reg.ime_enable_req = false;
+    cpu->mem->interrupt_mask = ime ? INTERRUPT_MASK_ALL : 0;
+    cpu->mem->interrupt_check &= ~INTERRUPT_CHECK_EI;
+    update_interrupt_check(cpu->mem);
+}
 static inline uint8_t reti(Cpu* cpu){
-    cpu->reg.ime = true;
+    set_ime(cpu, true);
     return ret(cpu);
 }
 static inline uint8_t rst_vec(Cpu* cpu, uint16_t vec){
@@ -790,6 +859,12 @@ static inline uint8_t cpl(Cpu* cpu){
     return 1;
 }
 static inline uint8_t daa(Cpu* cpu){
+#if ALU_LOOKUP_TABLES_ON
+    uint16_t result = daa_table[daa_table_index(cpu->reg.a, cpu->reg.f)];
+    cpu->reg.a = result >> 8;
+    cpu->reg.f = (cpu->reg.f & (FLAG_N | FLAG_UNUSED)) | (result & 0xFF);
+    return 1;
+#else
     uint8_t reg = cpu->reg.a;
     bool init_carry = get_carry_flag(&cpu->reg);
     bool init_h = get_half_carry_flag(&cpu->reg);
@@ -818,13 +893,16 @@ static inline uint8_t daa(Cpu* cpu){
     set_zero_flag(&cpu->reg, reg == 0);
     cpu->reg.a = reg;
     return 1;
+#endif
 }
 static inline uint8_t di(Cpu* cpu){
-    cpu->reg.ime = false;
+    set_ime(cpu, false);
     return 1;
 }
 static inline uint8_t ei(Cpu* cpu){
+    // IME comes on after the next instruction (see tick)
     cpu->reg.ime_enable_req = true;
+    cpu->mem->interrupt_check |= INTERRUPT_CHECK_EI_ARMED;
     return 1;
 }
 static inline uint8_t halt(Cpu* cpu){
@@ -10,7 +10,7 @@
  * ========================================
 */
 #include <project.h>
-#include "cpu.h"
+#include "emulator.h"
 #include "stdio.h"
 #include "rom.h"
 #include "GUI.h"
@@ -18,18 +18,23 @@
 #include "tft.h"
 #include "debugfuncs.h"
 #include "emumode.h"
-#include "mmio.h"
-#include "timer.h"
+#include "trace.h"
 
 
-Cpu cpu;
-Gpu gpu;
-Memory mem;
-Mmio mmio;
-Timer timer;
+Emulator emu;
+#if PROFILER_ON
+Profiler profiler;
+#endif
+#if SUBSYSTEM_TIMING_ON
+PerfStats perf;
+#endif
+#if TRACE_BINARY_THROUGH_SERIAL
+TraceEncoder trace;
+#endif
+
+// from power on until the panel and the joystick ADCs are used
+#define POWER_ON_WAIT_MS 500
 
-unsigned long total_cycles = 0;
-unsigned long total_instrs = 0;
 char buffer[500];
 double seconds = 0;
 
@@ -38,9 +43,9 @@ CY_ISR(Timer_1_Handler){
     sprintf(buffer, "On-time (sec): %d  \n"
         "Instrs/second: %lu \n"
         "Cycles/second: %lu \n"
-        "Machine Cycles/second:\n %lu\n PC: %x", (int) seconds, total_instrs/4, total_cycles, total_cycles/4, cpu.reg.pc);
-    total_cycles = 0;
-    total_instrs = 0;
+        "Machine Cycles/second:\n %lu\n PC: %x", (int) seconds, emu.total_instrs/4, emu.total_cycles, emu.total_cycles/4, emu.cpu.reg.pc);
+    emu.total_cycles = 0;
+    emu.total_instrs = 0;
     
     GUI_DispStringAt(buffer, 0, 0); 
     seconds += 4;
@@ -48,32 +53,65 @@ CY_ISR(Timer_1_Handler){
     */
 }
 
+static void write_line_uart(void* ctx, const char* line){
+    UART_1_PutString(line);
+}
+
 bool debug_trace_through_serial_on = false;
-static inline void tick_all(){
+bool trace_binary_on = false;
+uint8_t last_cycles = 0;
+static inline void trace_all(){
     if (DEBUG_MODE && DEBUG_TRACE_THROUGH_SERIAL){
-        if (debug_trace_through_serial_on || cpu.reg.pc >= DEBUG_TRACE_THROUGH_SERIAL_BREAKPOINT){
+        if (debug_trace_through_serial_on || emu.cpu.reg.pc >= DEBUG_TRACE_THROUGH_SERIAL_BREAKPOINT){
             debug_trace_through_serial_on = true;
-            debug_fmt_cpu_trace(buffer, &cpu, &mem, total_instrs, total_cycles);
+            debug_fmt_cpu_trace(buffer, &emu.cpu, &emu.mem, emu.total_instrs, emu.total_cycles);
             UART_1_PutString(buffer);
         }
     }
-    int cycles_taken = tick(&cpu);
-    if (cpu.inBios){
-        cpu.inBios = (fetch(&mem, 0xFF50, cpu.inBios) == 0);
+#if TRACE_BINARY_THROUGH_SERIAL
+    if (trace_binary_on || emu.cpu.reg.pc >= TRACE_BINARY_START_PC){
+        trace_binary_on = true;
+        trace_instruction(&trace, &emu.cpu, last_cycles);
+        trace_drain_uart(&trace);
     }
-    tick_mmio(&mmio);
-    tick_gpu(&gpu, cycles_taken);
-    tick_timer(&timer, cycles_taken);
-    total_cycles += cycles_taken;
-    total_instrs++;
+#endif
+}
+// Passes the game's serial output on to UART_1, as far as the TX FIFO has room
+// (with SERIAL_TX_ISR_ON the TX interrupt does, see start_serial_uart_isr)
+static inline void drain_serial(){
+#if !SERIAL_TX_ISR_ON
+    if (!serial_ring_empty(&emu.serial.out)){
+        serial_drain_uart(&emu.serial.out);
+    }
+#endif
+}
+static inline void tick_all(){
+    drain_serial();
+    trace_all();
+    last_cycles = tick_emulator(&emu);
+}
+static inline void tick_all_boot(){
+    drain_serial();
+    trace_all();
+    last_cycles = tick_emulator_boot(&emu);
+}
+static inline void tick_all_booted(){
+    drain_serial();
+#if TRACE_BINARY_THROUGH_SERIAL || (DEBUG_MODE && DEBUG_TRACE_THROUGH_SERIAL)
+    trace_all();
+    last_cycles = tick_emulator_booted(&emu);
+#else
+    // nothing to trace per instruction, so run up to the next event at a time
+    last_cycles = tick_emulator_batch(&emu);
+#endif
 }
 CY_ISR(button_press_1_handler){
     if (DEBUG_MODE){
         if (DEBUG_SHOW_VRAM_ON_BUTTON){
-            debug_show_full_vram(&mem);
+            debug_show_full_vram(&emu.mem);
         } else {
             tick_all(); 
-            debug_fmt_cpu_state(buffer, &cpu, &mem, total_instrs, total_cycles, DEBUG_MEMORY_DISPLAY_LOC);
+            debug_fmt_cpu_state(buffer, &emu.cpu, &emu.mem, emu.total_instrs, emu.total_cycles, DEBUG_MEMORY_DISPLAY_LOC);
             GUI_DispStringAt(buffer, 0, 0);
         }
     }
@@ -84,6 +122,8 @@ int main()
 {
     CyGlobalIntEnable; /* Enable global interrupts. */
     /* Place your initialization/startup code here (e.g. MyInst_Start()) */
+    perf_clock_start();
+    PerfTicks power_on = perf_now();
 
                 
     if (DEBUG_MODE){
@@ -100,7 +140,13 @@ int main()
     ADC_JOY_Y_StartConvert();
     ADC_JOY_X_StartConvert();
     
-    CyDelay(500);
+    // The hardware settles (POWER_ON_WAIT_MS, then TFT_SETTLE_MS after tftStartBegin) while the
+    // emulator is set up, instead of the setup waiting its turn after it
+    bool fits = setup_emulator(&emu, NULL);
+#if SERIAL_TX_ISR_ON
+    start_serial_uart_isr(&emu.serial.out);
+#endif
+    while (perf_us_since(power_on) < POWER_ON_WAIT_MS * 1000UL){}
     UART_1_PutString("Hello from the PSOC GB Emulator\r\n");
     if (DEBUG_MODE){
         // Only use emWin to print text in debug mode
@@ -115,37 +161,47 @@ int main()
         Timer_1_Start();
         */
     } else {
-        tftStart();    // initialize the TFT display
-        uint16 SC = 0;                     
-        uint16 EC = 159;
-        uint16 SP = 0;
-        uint16 EP = 143;
-        write8_a0(0x2A);                 	// send Column Address Set command
-        write8_a1(SC >> 8);                 // set SC[15:0]
-        write8_a1(SC & 0x00FF);
-        write8_a1(EC >> 8);                 // set EC[15:0]
-        write8_a1(EC & 0x00FF);
-        write8_a0(0x2B);                 	// send Page Address Set command
-        write8_a1(SP >> 8);                 // set SP[15:0]
-        write8_a1(SP & 0x00FF);
-        write8_a1(EP >> 8);                 // set EP[15:0]
-        write8_a1(EP & 0x00FF);
-
+        tftStartBegin();    // initialize the TFT display, finished below
     }
     
+    report_emulator_layout(&emu, write_line_uart, NULL);
+    if (!fits){
+        // the cartridge and the features that are on need more than EMULATOR_ARENA_SIZE (emumode.h)
+        UART_1_PutString("Out of memory, halted\r\n");
+        for (;;);
+    }
+#if PROFILER_ON
+    reset_profiler(&profiler);
+    emu.cpu.profiler = &profiler;
+#endif
+#if SUBSYSTEM_TIMING_ON
+    setup_perf_stats(&perf, SUBSYSTEM_TIMING_REPORT_INTERVAL_FRAMES, NULL, NULL);
+    set_perf_stats(&emu, &perf);
+#endif
+#if TRACE_BINARY_THROUGH_SERIAL
+    setup_trace(&trace);
+#endif
     
-    setup_cpu(&cpu, &mem);
-    setup_mmio(&mmio, &mem);
-    setup_gpu(&gpu, &mem);
-    setup_timer(&timer, &mem);
-    reset_memory(&mem);
-    cpu.inBios = START_IN_BIOS;
+    if (!DEBUG_MODE){
+        tftStartFinish();
+        // the gameboy screen goes in the middle of the panel, at OUTPUT_SCALE, with black around it
+#if SCALED(DISPLAY_WIDTH, OUTPUT_SCALE) > TFT_WIDTH || SCALED(DISPLAY_HEIGHT, OUTPUT_SCALE) > TFT_HEIGHT
+#error "OUTPUT_SCALE does not fit on the panel"
+#endif
+        uint16 SC = (TFT_WIDTH - SCALED(DISPLAY_WIDTH, OUTPUT_SCALE)) / 2;
+        uint16 EC = SC + SCALED(DISPLAY_WIDTH, OUTPUT_SCALE) - 1;
+        uint16 SP = (TFT_HEIGHT - SCALED(DISPLAY_HEIGHT, OUTPUT_SCALE)) / 2;
+        uint16 EP = SP + SCALED(DISPLAY_HEIGHT, OUTPUT_SCALE) - 1;
+        if (OUTPUT_SCALE != OUTPUT_SCALE_1X) tftClear();
+        tftSetWindow(SC, EC, SP, EP);
+
+    }
     
 
     if (DEBUG_MODE){
         for (;;){
-            if (!DEBUG_BREAKPOINT_ON || cpu.reg.pc == DEBUG_BREAKPOINT){
-                debug_fmt_cpu_state(buffer, &cpu, &mem, total_instrs, total_cycles, DEBUG_MEMORY_DISPLAY_LOC);
+            if (!DEBUG_BREAKPOINT_ON || emu.cpu.reg.pc == DEBUG_BREAKPOINT){
+                debug_fmt_cpu_state(buffer, &emu.cpu, &emu.mem, emu.total_instrs, emu.total_cycles, DEBUG_MEMORY_DISPLAY_LOC);
                 GUI_DispStringAt(buffer, 0, 0);
                 break;
             }
@@ -153,9 +209,18 @@ int main()
         }
     } else {
         
+        // Boot rom first, in its own loop, so the main loop never checks for it
+        // (with START_IN_BIOS false, setup_emulator has skipped it)
+        while (emu.cpu.inBios){
+            tick_all_boot();
+        }
         for(;;)
         {
-            tick_all();
+            tick_all_booted();
+            if (PROFILER_ON && emu.cpu.profiler && emu.gpu.frame_count == PROFILER_REPORT_FRAME){
+                profiler_report_uart(emu.cpu.profiler);
+                emu.cpu.profiler = NULL;
+            }
         }
        
     }
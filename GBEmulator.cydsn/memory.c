@@ -2,18 +2,162 @@
 #include <project.h>
 #include "rom.h"
 #include "cpu.h"
+#include "serial.h"
 #include "stdint.h"
 #include "stdbool.h"
 #include "emumode.h"
+#include "stddef.h"
+#include "string.h"
+
+// The named I/O registers have to line up with their addresses in io
+#define IO_REGISTER_AT(field, loc) \
+    _Static_assert(offsetof(Memory, field) == offsetof(Memory, io) + (loc) - IO_START, #field " is not at " #loc)
+IO_REGISTER_AT(joyp, JOYP_LOC);
+IO_REGISTER_AT(sb, SB_LOC);
+IO_REGISTER_AT(sc, SC_LOC);
+IO_REGISTER_AT(timer_divider, TIMER_DIV_LOC);
+IO_REGISTER_AT(timer_control, TIMER_CONTROL_LOC);
+IO_REGISTER_AT(interrupt_flag, INTERRUPT_FLAG_LOC);
+IO_REGISTER_AT(sound, SOUND_START);
+IO_REGISTER_AT(lcdc, LCDC_LOC);
+IO_REGISTER_AT(current_scan_line, LY_LOC);
+IO_REGISTER_AT(background_palette, BG_PALETTE_LOC);
+IO_REGISTER_AT(wy, WY_LOC);
+IO_REGISTER_AT(wx, WX_LOC);
+IO_REGISTER_AT(boot, BOOT_LOC);
+IO_REGISTER_AT(zero_page, ZERO_PAGE_START);
+
+// Registers with a flag of 0 are plain: reads return io[], writes store to io[] and nothing else.
+// Every write that can move the gpu's, timer's or serial port's next event (and end a run_cycles
+// batch through stop_batch) has IO_WRITE_HOOK. Unmapped registers have both, and read 0
+#define IO_HOOKS (IO_READ_HOOK | IO_WRITE_HOOK)
+#define IO_FLAGS(loc) [(loc) - IO_START]
+const uint8_t io_register_flags[IO_SIZE] SRAM_TABLE(io_register_flags) = {
+    [0 ... IO_SIZE - 1] = IO_HOOKS,
+    IO_FLAGS(JOYP_LOC) = IO_WRITE_HOOK,          // mmio fills in the buttons for the selected row
+    IO_FLAGS(SB_LOC) = 0,
+    IO_FLAGS(SC_LOC) = IO_WRITE_HOOK,            // starts a transfer
+    IO_FLAGS(TIMER_DIV_LOC) = IO_WRITE_HOOK,     // any write resets DIV
+    IO_FLAGS(TIMER_COUNTER_LOC) = IO_WRITE_HOOK,
+    IO_FLAGS(TIMER_MODULO_LOC) = IO_WRITE_HOOK,
+    IO_FLAGS(TIMER_CONTROL_LOC) = IO_WRITE_HOOK,
+    IO_FLAGS(INTERRUPT_FLAG_LOC) = IO_WRITE_HOOK, // interrupt_check
+    // the sound registers (IO_HOOKS) have read masks, and writes are logged for the apu
+    IO_FLAGS(LCDC_LOC) = 0,
+    IO_FLAGS(LCD_STATUS_LOC) = 0,
+    IO_FLAGS(SCY_LOC) = 0,
+    IO_FLAGS(SCX_LOC) = 0,
+    IO_FLAGS(LY_LOC) = DEBUG_MODE_STUB_LY_0x90 ? IO_HOOKS : IO_WRITE_HOOK,   // read only
+    IO_FLAGS(LYC_LOC) = 0,
+    IO_FLAGS(OAM_DMA_LOC) = IO_HOOKS,            // start_dma
+    IO_FLAGS(BG_PALETTE_LOC) = 0,
+    IO_FLAGS(OBP0_LOC) = 0,
+    IO_FLAGS(OBP1_LOC) = 0,
+    IO_FLAGS(WY_LOC) = 0,
+    IO_FLAGS(WX_LOC) = 0,
+    IO_FLAGS(BOOT_LOC) = IO_WRITE_HOOK,          // unmaps the boot rom
+};
+
+// Where the OAM_SIZE bytes from source sit in one array, NULL when they don't
+// Every region is a whole number of pages, so a DMA source page is never split between two
+static const uint8_t* dma_source(Memory* mem, uint16_t source){
+    if (source < ROM_END) return mem->rom + source;
+    if ((uint16_t)(source - VRAM_START) < VRAM_SIZE) return mem->vram + (source - VRAM_START);
+    if ((uint16_t)(source - WRAM_START) < WRAM_SIZE) return mem->wram + (source - WRAM_START);
+    if ((uint16_t)(source - ECHO_RAM_START) < ECHO_RAM_SIZE) return mem->wram + (source - ECHO_RAM_START);
+    if ((uint16_t)(source - EXTERNAL_RAM_START) < EXTERNAL_RAM_SIZE &&
+        source - EXTERNAL_RAM_START + OAM_SIZE <= mem->eram_size){
+        return mem->eram + (source - EXTERNAL_RAM_START);
+    }
+    return NULL;
+}
 
 // Emulates a dma transfer
+// The copy is done at once; the OAM_DMA_CYCLES the real one takes only lock the cpu out of the bus
+// (dma_cycles_left), which the emulator counts down and ends its batches on like any other event
 static void start_dma(Memory* mem, uint8_t xx){
     // Source:      $XX00-$XX9F   ;XX = $00 to $DF
     // Destination: $FE00-$FE9F
     uint16_t source = xx << 8;
-    int i;  // copy 160 bytes
-    for (i=0;i<160;i++){
-        mem->oam[i] = fetch(mem, source + i, false);
+    const uint8_t* block = dma_source(mem, source);
+    mem->dma_cycles_left = 0;   // a DMA restarted during the lock still reads its source
+    if (block){
+        memcpy(mem->oam, block, OAM_SIZE);
+    } else {
+        // cartridge ram smaller than a page, or 0xFE00 and up
+        int i;
+        for (i=0;i<OAM_SIZE;i++){
+            mem->oam[i] = fetch_mapped(mem, source + i);
+        }
+    }
+    mem->dma_cycles_left = OAM_DMA_CYCLES;
+}
+
+// What reads of each sound register return on top of the register, for the bits that read back as 1
+static const uint8_t sound_read_masks[SOUND_SIZE] = {
+    0x80, 0x3F, 0x00, 0xFF, 0xBF,   // NR10-NR14
+    0xFF, 0x3F, 0x00, 0xFF, 0xBF,   // unused, NR21-NR24
+    0x7F, 0xFF, 0x9F, 0xFF, 0xBF,   // NR30-NR34
+    0xFF, 0xFF, 0x00, 0x00, 0xBF,   // unused, NR41-NR44
+    0x00, 0x00, 0x70,               // NR50-NR52
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   // unused
+    // wave RAM reads back as written
+};
+
+static uint8_t fetch_sound(Memory* memory, uint16_t address){
+    uint8_t reg = address - SOUND_START;
+    if (address == NR52_LOC){
+        return (memory->sound[reg] & 0x80) | sound_read_masks[reg] | memory->sound_status;
+    }
+    return memory->sound[reg] | sound_read_masks[reg];
+}
+
+// Stores a sound register and logs the write for the apu
+static void write_sound(Memory* memory, uint16_t address, uint8_t data){
+    uint8_t reg = address - SOUND_START;
+    bool powered = memory->sound[NR52_LOC - SOUND_START] & 0x80;
+    // with the sound off, only NR52 and wave RAM can be written
+    if (!powered && address < NR52_LOC) return;
+    if (address == NR52_LOC){
+        data &= 0x80;
+        if (!data){
+            int i;
+            for (i = 0; i < NR52_LOC - SOUND_START; i++){
+                memory->sound[i] = 0;
+            }
+            memory->sound_status = 0;
+        }
+    }
+    memory->sound[reg] = data;
+    
+    // triggering a channel turns it on straight away, as far as NR52 reads go
+    static const uint8_t trigger_regs[4] = {0x04, 0x09, 0x0E, 0x13};
+    int channel;
+    for (channel = 0; channel < 4; channel++){
+        if (reg == trigger_regs[channel] && (data & 0x80)) memory->sound_status |= 1 << channel;
+    }
+    
+    if (memory->sound_write_count == SOUND_WRITE_LOG_SIZE){
+        if (memory->sound_log_full_hook){
+            memory->sound_log_full_hook(memory->sound_log_full_hook_ctx);
+        }
+        memory->sound_write_count = 0;
+    }
+    SoundWrite* write = &memory->sound_writes[memory->sound_write_count++];
+    write->time = memory->cycle_clock ? (uint32_t) *memory->cycle_clock * 4 : 0;
+    write->reg = reg;
+    write->data = data;
+}
+
+uint16_t cart_ram_size(const uint8_t* rom){
+    switch (rom[CART_RAM_SIZE_LOC]){
+        case 0x00: return 0;
+        case 0x01: return 0x800;                // 2KB
+        case 0x02:                              // 8KB
+        case 0x03:                              // 32KB, 128KB and 64KB: only the first bank is mapped
+        case 0x04:
+        case 0x05: return EXTERNAL_RAM_SIZE;
+        default: return 0;
     }
 }
 
@@ -47,20 +191,16 @@ void reset_memory(Memory* memory){
 //	0150-3FFF 	Cartridge ROM - Bank 0 (fixed)
 //	0100-014F 	Cartridge Header Area
 //  0000-00FF 	Restart and Interrupt Vectorss
-uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
-    if (DEBUG_MODE && DEBUG_MODE_STUB_LY_0x90 && address == LY_LOC){
-        return 0x90;
-    }
-    
-    if (ROM_START <= address && address < ROM_END) {
-        if (inBios && address < BIOS_SIZE) {
-            return bios[address];
-        }
-        return rom[address];
+SRAM_CODE uint8_t fetch_mapped(Memory* memory, uint16_t address){
+    if (memory->dma_cycles_left && address < IO_START){
+        return 0xFF;
+    } else if (ROM_START <= address && address < ROM_END) {
+        return memory->rom[address];
     } else if (VRAM_START <= address && address < VRAM_END) {
         return memory->vram[address - VRAM_START];
     } else if (EXTERNAL_RAM_START <= address && address < EXTERNAL_RAM_END){
-        return memory->eram[address - EXTERNAL_RAM_START];
+        uint16_t offset = address - EXTERNAL_RAM_START;
+        return offset < memory->eram_size ? memory->eram[offset] : 0xFF;
     } else if (WRAM_START <= address && address < WRAM_END) {
         return memory->wram[address - WRAM_START];
     } else if (ECHO_RAM_START <= address && address < ECHO_RAM_END){
@@ -69,6 +209,11 @@ uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
         return memory->oam[address - OAM_START];
     } else if (ZERO_PAGE_START <= address && address < ZERO_PAGE_END){
         return memory->zero_page[address - ZERO_PAGE_START];
+    } else if (IO_REGISTER_TABLE_ON && (uint16_t)(address - IO_START) < IO_SIZE &&
+               !(io_register_flags[address - IO_START] & IO_READ_HOOK)){
+        return memory->io[address - IO_START];
+    } else if (SOUND_START <= address && address < SOUND_END){
+        return fetch_sound(memory, address);
     }else {
         switch (address){
             case INTERRUPT_ENABLE_LOC:
@@ -84,7 +229,7 @@ uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
             case SCY_LOC:
                 return memory->scroll_y;
             case LY_LOC:
-                return memory->current_scan_line;
+                return DEBUG_MODE_STUB_LY_0x90 ? 0x90 : memory->current_scan_line;
             case LYC_LOC:
                 return memory->lyc;
             case JOYP_LOC:
@@ -111,6 +256,8 @@ uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
                 return memory->timer_modulo;
             case TIMER_CONTROL_LOC:
                 return memory->timer_control;
+            case BOOT_LOC:
+                return memory->boot;
             default: break;
         }
     
@@ -120,18 +267,19 @@ uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
 }
 
 
-void write_mem(Memory* memory, uint16_t address, uint8_t data) {
-    if (GB_SERIAL_PASSTHROUGH && address == 0xFF02 && data == 0x81) {
-        // Pass through GB serial in debug mode
-        UART_1_PutChar(fetch(memory, 0xFF01, false));
-    }   
-    
-    if (ROM_START <= address && address < ROM_END) {
+SRAM_CODE void write_mem(Memory* memory, uint16_t address, uint8_t data) {
+    if (memory->dma_cycles_left && address < IO_START){
+        // the bus belongs to the OAM DMA
+    } else if (ROM_START <= address && address < ROM_END) {
         // Nothing to do... can't write to ROM
     } else if (VRAM_START <= address && address < VRAM_END) {
         memory->vram[address - VRAM_START] = data;
+        if (address >= TILE_MAP_START) {
+            memory->tile_map_writes++;
+        }
     } else if (EXTERNAL_RAM_START <= address && address < EXTERNAL_RAM_END){
-        memory->eram[address - EXTERNAL_RAM_START] = data;
+        uint16_t offset = address - EXTERNAL_RAM_START;
+        if (offset < memory->eram_size) memory->eram[offset] = data;
     } else if (WRAM_START <= address && address < WRAM_END) {
         memory->wram[address - WRAM_START] = data;
     } else if (ECHO_RAM_START <= address && address < ECHO_RAM_END){
@@ -140,13 +288,22 @@ void write_mem(Memory* memory, uint16_t address, uint8_t data) {
         memory->oam[address - OAM_START] = data;
     } else if (ZERO_PAGE_START <= address && address < ZERO_PAGE_END){
         memory->zero_page[address - ZERO_PAGE_START] = data;
+    } else if (IO_REGISTER_TABLE_ON && (uint16_t)(address - IO_START) < IO_SIZE &&
+               !(io_register_flags[address - IO_START] & IO_WRITE_HOOK)){
+        memory->io[address - IO_START] = data;
+    } else if (SOUND_START <= address && address < SOUND_END){
+        write_sound(memory, address, data);
     }else {
+        // the registers here can move the gpu's, timer's or serial port's next event
+        memory->stop_batch = true;
         switch (address){
             case INTERRUPT_ENABLE_LOC:
             memory->interrupt_enable = data;
+            update_interrupt_check(memory);
             break;
             case INTERRUPT_FLAG_LOC:
             memory->interrupt_flag = data;
+            update_interrupt_check(memory);
             break;
             case LCDC_LOC:
             memory->lcdc = data;
@@ -168,6 +325,19 @@ void write_mem(Memory* memory, uint16_t address, uint8_t data) {
             break;
             case SC_LOC:
             memory->sc = data;
+            memory->serial_cycles_left = 0;
+            if ((data & (SC_TRANSFER_START | SC_INTERNAL_CLOCK)) == (SC_TRANSFER_START | SC_INTERNAL_CLOCK)){
+                // tick_serial finishes the transfer
+                memory->serial_cycles_left = SERIAL_TRANSFER_CYCLES;
+#if GB_SERIAL_PASSTHROUGH
+                // Pass through GB serial, never waiting on the UART here
+                if (memory->serial_hook){
+                    memory->serial_hook(memory->serial_hook_ctx, memory->sb);
+                } else if (memory->serial_ring){
+                    serial_ring_put(memory->serial_ring, memory->sb);
+                }
+#endif
+            }
             break;
             case BG_PALETTE_LOC:
             memory->background_palette = data;
@@ -204,6 +374,9 @@ void write_mem(Memory* memory, uint16_t address, uint8_t data) {
             case TIMER_CONTROL_LOC:
             memory->timer_control = data;
             break;
+            case BOOT_LOC:
+            memory->boot = data;
+            break;
             default: break;
         }
     
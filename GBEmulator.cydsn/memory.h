@@ -2,12 +2,19 @@
 #define MEMORY_H
 #include "stdint.h"
 #include "stdbool.h"
+#include "emumode.h"
+#include "sram_code.h"
+#include "rom.h"
 #define ECHO_RAM_SIZE 0x1E00
 #define ECHO_RAM_START 0xE000
 #define ECHO_RAM_END 0xFE00
 #define EXTERNAL_RAM_START 0xA000
 #define EXTERNAL_RAM_END 0xC000
-#define EXTERNAL_RAM_SIZE 0x2000
+#define EXTERNAL_RAM_SIZE 0x2000         // one bank; without an MBC there is no banking, so no more is mapped
+#define CART_RAM_SIZE_LOC 0x0149          // cartridge header byte giving the ram on the cartridge
+#define CART_LOGO_LOC 0x0104              // the 48 byte Nintendo logo in the cartridge header
+#define CART_LOGO_SIZE 48
+#define CART_HEADER_CHECKSUM_LOC 0x014D   // checksum over 0x0134-0x014C
 #define WRAM_SIZE 0x2000
 #define VRAM_SIZE 0x2000
 #define OAM_SIZE 0xA0
@@ -17,8 +24,11 @@
 #define ROM_END 0x8000
 #define VRAM_START 0x8000
 #define VRAM_END 0xA000
+#define TILE_MAP_START 0x9800         // the two 32x32 background/window tile maps, up to VRAM_END
 #define WRAM_START 0xC000
 #define WRAM_END 0xE000
+#define IO_START 0xFF00                   // I/O registers
+#define IO_SIZE 0x80
 #define ZERO_PAGE_START 0xFF80
 #define ZERO_PAGE_END 0xFFFF
 #define ZERO_PAGE_SIZE 0x7F
@@ -31,6 +41,11 @@
 #define INTERRUPT_ENABLE_TIMER_MASK    0b00100
 #define INTERRUPT_ENABLE_SERIAL_MASK   0b01000
 #define INTERRUPT_ENABLE_JOYPAD_MASK   0b10000
+#define INTERRUPT_MASK_ALL             0b11111
+// Memory.interrupt_check bits on top of the pending interrupts (see tick in cpu.c)
+#define INTERRUPT_CHECK_EI_ARMED  0x20   // EI ran this instruction
+#define INTERRUPT_CHECK_EI_DUE    0x40   // IME comes on before this instruction's interrupt check
+#define INTERRUPT_CHECK_EI (INTERRUPT_CHECK_EI_ARMED | INTERRUPT_CHECK_EI_DUE)
 // LCD status mask on lcd_stat
 #define LCD_STAT_LY_LYC_INTERRUPT_REG_MASK 0b1000000
 #define LCD_STAT_OAM_INTERRUPT_REG_MASK    0b0100000
@@ -59,51 +74,196 @@
 #define WY_LOC 0xFF4A                // start of window y
 #define SB_LOC 0xFF01                // serial buffer
 #define SC_LOC 0xFF02                // serial control
+#define SC_TRANSFER_START 0x80       // SC bit 7, set while a transfer is in progress
+#define SC_INTERNAL_CLOCK 0x01       // SC bit 0, this gameboy drives the clock
+#define SERIAL_TRANSFER_CYCLES 1024  // machine cycles for 8 bits at 8192 Hz
 #define OAM_DMA_LOC 0xFF46           // OAM DMA start loc
+#define OAM_DMA_CYCLES 160           // machine cycles an OAM DMA keeps the cpu off the bus below 0xFF00
 #define TIMER_DIV_LOC 0xFF04         // timer divider loc
 #define TIMER_COUNTER_LOC 0xFF05     // TIMA timer counter 
 #define TIMER_MODULO_LOC 0xFF06      // TMA timer modulo (reload value)
 #define TIMER_CONTROL_LOC 0xFF07      // TAC timer control register
+#define TIMER_CONTROL_ENABLE_MASK 0x04  // TAC bit 2, TIMA counts while it is set
+#define BOOT_LOC 0xFF50               // boot rom disable
+#define SOUND_START 0xFF10            // sound registers NR10-NR52, then wave RAM from 0xFF30
+#define SOUND_END 0xFF40
+#define SOUND_SIZE (SOUND_END - SOUND_START)
+#define NR52_LOC 0xFF26               // sound on/off and channel status
+#define WAVE_RAM_START 0xFF30
+#define SOUND_WRITE_LOG_SIZE 256
+// io_register_flags bits, for the I/O registers fetch_mapped and write_mem can't just read or store
+#define IO_READ_HOOK 0x01             // reads go through fetch_mapped's switch (computed or unmapped)
+#define IO_WRITE_HOOK 0x02            // writes go through write_mem's switch (side effects, or can move an event)
+
+// A write to a sound register or wave RAM, logged for the apu to replay at the time it happened (see apu.h)
+typedef struct SoundWrite {
+    uint32_t time;     // T-cycle the write happened on
+    uint8_t reg;       // address - SOUND_START
+    uint8_t data;
+} SoundWrite;
+
 typedef struct Memory {
+    const uint8_t* rom;              // cartridge rom mapped to 0x0000-0x7FFF
+    uint8_t* eram;                   // external ram, eram_size bytes from the emulator's arena (see arena.h)
+    uint16_t eram_size;              // cart_ram_size of the rom; 0 for carts without ram, which read 0xFF
     uint8_t wram[WRAM_SIZE];         // work ram
-    uint8_t eram[EXTERNAL_RAM_SIZE]; // external ram
     uint8_t vram[VRAM_SIZE];         // video ram
 
     uint8_t oam[OAM_SIZE];     // Sprite attribute table (OAM)
+    // I/O registers (0xFF00-0xFF7F), both as one array and by name. The plain ones (io_register_flags 0)
+    // are read and written straight in io; the rest go through the switches in fetch_mapped and write_mem
+    union {
+        uint8_t io[IO_SIZE];
+        struct {
+            uint8_t joyp;              //Joypad register located on 0xFF00;
+            // Serial communication
+            uint8_t sb;  //SB serial transfer data    (located on 0xFF01)
+            uint8_t sc;  //SC serial transfer control (located on 0xFF02)
+            uint8_t unmapped_03;
+            // Timer
+            uint8_t timer_divider;     // Timer divider DIV
+            uint8_t timer_counter;     // Timer counter TIMA
+            uint8_t timer_modulo;      // Timer Modulo TMA
+            uint8_t timer_control;     // Timer Control TAC
+            uint8_t unmapped_08[7];
+            uint8_t interrupt_flag;    // interrupt flag (located on 0xFF0F)
+            // Sound
+            uint8_t sound[SOUND_SIZE];  // NR10-NR52 and wave RAM as last written (located on 0xFF10-0xFF3F)
+            // GPU registers
+            uint8_t lcdc;              // LCD Control (R/W located on 0xFF40)
+            uint8_t lcdstatus;         // LCD Status  (R/Wlocated on 0xFF41)
+            uint8_t scroll_y;          // SCY (R/W located on 0xFF42)
+            uint8_t scroll_x;          // SCX (R/W located on 0xFF43)
+            uint8_t current_scan_line; // LY  (R located on 0xFF44)
+            uint8_t lyc;               // LYC (used for ly compare interrupts)
+            uint8_t dma_unstored;      // DMA (0xFF46) only starts start_dma, and reads 0
+            uint8_t background_palette; // (W located on 0xFF47)
+            uint8_t obp0;              // OBP0 object palette 0 (located on 0xFF48) 
+            uint8_t obp1;              // OBP1 object palette 1 (located on 0xFF49) 
+            uint8_t wy;                // window y position
+            uint8_t wx;                // window x position + 7
+            uint8_t unmapped_4c[4];
+            uint8_t boot;              // BOOT, the boot rom unmaps itself by writing it (located on 0xFF50)
+        };
+    };
     uint8_t zero_page[ZERO_PAGE_SIZE];       // High address RAM (stack here)
     uint8_t interrupt_enable;  // interrupt enable (located on 0xFFFF)
-    uint8_t interrupt_flag;    // interrupt flag (located on 0xFF0F)
-    
-    // GPU registers
-    uint8_t lcdc;              // LCD Control (R/W located on 0xFF40)
-    uint8_t lcdstatus;         // LCD Status  (R/Wlocated on 0xFF41)
-    uint8_t scroll_y;          // SCY (R/W located on 0xFF42)
-    uint8_t scroll_x;          // SCX (R/W located on 0xFF43)
-    uint8_t current_scan_line; // LY  (R located on 0xFF44)
-    uint8_t lyc;               // LYC (used for ly compare interrupts)
-    uint8_t background_palette; // (W located on 0xFF47)
-    uint8_t obp0;              // OBP0 object palette 0 (located on 0xFF48) 
-    uint8_t obp1;              // OBP1 object palette 1 (located on 0xFF49) 
-    uint8_t wx;                // window x position + 7
-    uint8_t wy;                // window y position
-    
-    // Serial communication
-    uint8_t sb;  //SB serial transfer data    (located on 0xFF01)
-    uint8_t sc;  //SC serial transfer control (located on 0xFF02)
-    // Joypad
-    uint8_t joyp;              //Joypad register located on 0xFF00;
+
+    uint16_t serial_cycles_left;  // machine cycles until the transfer in progress finishes, 0 for none
+    uint8_t dma_cycles_left;   // machine cycles until the OAM DMA in progress lets go of the bus, 0 for none
+    uint32_t tile_map_writes;  // bumped by every write to the tile maps, invalidates the gpu's TileRowCaches
+
+    // Sound
+    uint8_t sound_status;       // channel on bits of NR52; set on trigger, cleared by the apu
+    uint16_t sound_write_count;
+    SoundWrite sound_writes[SOUND_WRITE_LOG_SIZE];  // writes the apu hasn't replayed yet
     
-    // Timer
-    uint8_t timer_divider;     // Timer divider DIV
-    uint8_t timer_counter;     // Timer counter TIMA
-    uint8_t timer_modulo;      // Timer Modulo TMA
-    uint8_t timer_control;     // Timer Control TAC
+    // Receives every byte the game sends over serial (GB_SERIAL_PASSTHROUGH)
+    // NULL queues the bytes in serial_ring instead, for serial_drain_uart
+    void (*serial_hook)(void* ctx, uint8_t data);
+    void* serial_hook_ctx;
+    struct SerialRing* serial_ring;   // see serial.h, NULL drops the bytes
+    // Machine cycle count sound writes are timed by (the emulator's total_cycles); NULL times them all 0
+    const unsigned long* cycle_clock;
+    // Called when sound_writes is full so the apu can replay it; NULL drops the log
+    void (*sound_log_full_hook)(void* ctx);
+    void* sound_log_full_hook_ctx;
+    // Kept up to date by whatever changes IE, IF or IME, so tick only tests one byte per instruction
+    // (derived state, which cpufuzz doesn't compare)
+    uint8_t interrupt_check;   // IE & IF & interrupt_mask, plus INTERRUPT_CHECK_EI_*; nonzero when tick has interrupt work
+    uint8_t interrupt_mask;    // INTERRUPT_MASK_ALL while IME is set, 0 otherwise
+    bool stop_batch;           // set by I/O register writes, ends run_cycles after the instruction
 } Memory;
-// Fetch a byte from memory
-uint8_t fetch(Memory* memory, uint16_t address, bool inBios);
-// Write a byte into memory
-void write_mem(Memory* memory, uint16_t address, uint8_t data);
+
+// Redoes the pending interrupts in interrupt_check after IE, IF or interrupt_mask change
+static inline void update_interrupt_check(Memory* memory){
+    memory->interrupt_check = (memory->interrupt_check & INTERRUPT_CHECK_EI) |
+        (memory->interrupt_enable & memory->interrupt_flag & memory->interrupt_mask);
+}
+// Sets the INTERRUPT_ENABLE_*_MASK bits of mask in IF
+static inline void request_interrupt(Memory* memory, uint8_t mask){
+    memory->interrupt_flag |= mask;
+    memory->interrupt_check |= mask & memory->interrupt_enable & memory->interrupt_mask;
+}
+// Counts down the bus lock of an OAM DMA by the machine cycles that elapsed
+static inline void tick_dma(Memory* memory, int delta_machine_cycles){
+    if (memory->dma_cycles_left == 0) return;
+    memory->dma_cycles_left = memory->dma_cycles_left > delta_machine_cycles ?
+        memory->dma_cycles_left - delta_machine_cycles : 0;
+}
+// IO_READ_HOOK and IO_WRITE_HOOK of each I/O register, indexed by address - IO_START
+extern const uint8_t io_register_flags[IO_SIZE];
+// Fetch a byte from the memory map, leaving out the boot rom
+// While an OAM DMA holds the bus, everything below the I/O registers reads 0xFF
+SRAM_CODE uint8_t fetch_mapped(Memory* memory, uint16_t address);
+// Fetch a byte from memory; inBios maps the boot rom over 0x0000-0x00FF
+// Inline so a constant inBios (see CPU_IN_BIOS) removes the check
+static inline uint8_t fetch(Memory* memory, uint16_t address, bool inBios){
+    if (inBios && address < BIOS_SIZE){
+        return bios[address];
+    }
+    return fetch_mapped(memory, address);
+}
+// Bytes of external ram the cartridge header of rom asks for, as far as 0xA000-0xBFFF maps
+uint16_t cart_ram_size(const uint8_t* rom);
+// Write a byte into memory; dropped below the I/O registers while an OAM DMA holds the bus
+SRAM_CODE void write_mem(Memory* memory, uint16_t address, uint8_t data);
 // Reset memory back to 0s
 void reset_memory(Memory* memory);
 
+// LDH: reads and writes 0xFF00 + offset, with plain I/O registers and HRAM as one indexed access
+// (IO_REGISTER_TABLE_ON); the rest, and IE, go through fetch_mapped and write_mem
+static inline uint8_t fetch_high(Memory* memory, uint8_t offset){
+    if (IO_REGISTER_TABLE_ON){
+        if (offset < IO_SIZE){
+            if (!(io_register_flags[offset] & IO_READ_HOOK)) return memory->io[offset];
+        } else if (offset != (uint8_t) INTERRUPT_ENABLE_LOC){
+            return memory->zero_page[offset - IO_SIZE];
+        }
+    }
+    return fetch_mapped(memory, IO_START + offset);
+}
+static inline void write_high(Memory* memory, uint8_t offset, uint8_t data){
+    if (IO_REGISTER_TABLE_ON){
+        if (offset < IO_SIZE){
+            if (!(io_register_flags[offset] & IO_WRITE_HOOK)){
+                memory->io[offset] = data;
+                return;
+            }
+        } else if (offset != (uint8_t) INTERRUPT_ENABLE_LOC){
+            memory->zero_page[offset - IO_SIZE] = data;
+            return;
+        }
+    }
+    write_mem(memory, IO_START + offset, data);
+}
+
+// Fast paths for the stack and (HL)/(BC)/(DE) operands, which are almost always in WRAM or HRAM
+// Those go straight to the array; anything else falls back to fetch/write_mem
+// (WRAM only while no OAM DMA holds the bus)
+static inline uint8_t fetch_ram(Memory* memory, uint16_t address, bool inBios){
+    if (FAST_RAM_ACCESS_ON){
+        if ((uint16_t)(address - WRAM_START) < WRAM_SIZE && !memory->dma_cycles_left){
+            return memory->wram[address - WRAM_START];
+        }
+        if ((uint16_t)(address - ZERO_PAGE_START) < ZERO_PAGE_SIZE){
+            return memory->zero_page[address - ZERO_PAGE_START];
+        }
+    }
+    return fetch(memory, address, inBios);
+}
+static inline void write_ram(Memory* memory, uint16_t address, uint8_t data){
+    if (FAST_RAM_ACCESS_ON){
+        if ((uint16_t)(address - WRAM_START) < WRAM_SIZE && !memory->dma_cycles_left){
+            memory->wram[address - WRAM_START] = data;
+            return;
+        }
+        if ((uint16_t)(address - ZERO_PAGE_START) < ZERO_PAGE_SIZE){
+            memory->zero_page[address - ZERO_PAGE_START] = data;
+            return;
+        }
+    }
+    write_mem(memory, address, data);
+}
+
 #endif
@@ -0,0 +1,7 @@
+#include "palette.h"
+
+const Palette palette_presets[PALETTE_PRESET_COUNT] = {
+    [PALETTE_GRAYSCALE]     = {{0xFFFF, 0xC618, 0x7BEF, 0x0000}},
+    [PALETTE_CLASSIC_GREEN] = {{0x9DE1, 0x8D61, 0x3306, 0x09C1}},
+    [PALETTE_HIGH_CONTRAST] = {{0xFFFF, 0xB5B6, 0x39E7, 0x0000}},
+};
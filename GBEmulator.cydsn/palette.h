@@ -0,0 +1,32 @@
+/*
+Colors the four DMG shades are drawn in
+The gpu compiles the selected palette of each layer into the RGB565 tables it renders through
+(see set_layer_palette in gpu.h), so picking a palette never costs anything per pixel
+*/
+#ifndef PALETTE_H
+#define PALETTE_H
+#include "stdint.h"
+
+// RGB565 of each shade, from shade 0 (lightest) to shade 3 (darkest)
+typedef struct Palette {
+    uint16_t shades[4];
+} Palette;
+
+typedef enum PalettePreset {
+    PALETTE_GRAYSCALE,
+    PALETTE_CLASSIC_GREEN,      // the original DMG screen
+    PALETTE_HIGH_CONTRAST,
+    PALETTE_PRESET_COUNT
+} PalettePreset;
+
+// Layers that each get their own palette, on top of their palette register
+typedef enum PaletteLayer {
+    PALETTE_LAYER_BG,           // background and window (BGP)
+    PALETTE_LAYER_OBJ0,         // sprites using OBP0
+    PALETTE_LAYER_OBJ1,         // sprites using OBP1
+    PALETTE_LAYER_COUNT
+} PaletteLayer;
+
+extern const Palette palette_presets[PALETTE_PRESET_COUNT];
+
+#endif
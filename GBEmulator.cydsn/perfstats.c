@@ -0,0 +1,87 @@
+#include "perfstats.h"
+#include <project.h>
+#include "stdio.h"
+#include "string.h"
+#ifdef HOST_BUILD
+#include "time.h"
+#define PERF_TICKS_PER_US 1000                       // ns
+#else
+#define PERF_TICKS_PER_US (BCLK__BUS_CLK__HZ / 1000000)   // cpu clock cycles
+// Cortex-M3 debug registers for the DWT cycle counter
+#define DEMCR       (*(volatile uint32_t*) 0xE000EDFC)
+#define DEMCR_TRCENA (1 << 24)
+#define DWT_CTRL    (*(volatile uint32_t*) 0xE0001000)
+#define DWT_CTRL_CYCCNTENA 1
+#define DWT_CYCCNT  (*(volatile uint32_t*) 0xE0001004)
+#endif
+
+static const char* subsystem_names[PERF_SUBSYSTEM_COUNT] = {
+    "cpu", "gpu", " render", "  dma_wait", "timer", "mmio"
+};
+
+PerfTicks perf_now(void){
+#ifdef HOST_BUILD
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return DWT_CYCCNT;
+#endif
+}
+
+void perf_clock_start(void){
+#ifndef HOST_BUILD
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+uint32_t perf_us_since(PerfTicks start){
+    return (uint32_t) ((PerfTicks) (perf_now() - start) / PERF_TICKS_PER_US);
+}
+
+static void write_line_uart(void* ctx, const char* line){
+    UART_1_PutString(line);
+}
+
+void setup_perf_stats(PerfStats* perf, uint32_t report_interval_frames, void (*write_line)(void* ctx, const char* line), void* ctx){
+    // not reset: the counter may already be timing something else (see tftStartBegin)
+    perf_clock_start();
+    memset(perf, 0, sizeof(PerfStats));
+    perf->report_interval_frames = report_interval_frames ? report_interval_frames : 1;
+    perf->write_line = write_line ? write_line : write_line_uart;
+    perf->write_line_ctx = ctx;
+    perf->window_start = perf_now();
+}
+
+void perf_frame_done(PerfStats* perf){
+    perf->frames++;
+    if (perf->frames < perf->report_interval_frames) return;
+    
+    // Everything is reported per frame, in microseconds
+    uint32_t window_us = (uint32_t) ((PerfTicks) (perf_now() - perf->window_start) / PERF_TICKS_PER_US);
+    uint32_t frame_us = window_us / perf->frames;
+    char line[96];
+    sprintf(line, "perf: %lu frames, %lu us/frame (%lu fps)\r\n", (unsigned long) perf->frames, (unsigned long) frame_us,
+        frame_us ? 1000000UL / frame_us : 0UL);
+    perf->write_line(perf->write_line_ctx, line);
+    uint32_t accounted_us = 0;
+    int i;
+    for (i = 0; i < PERF_SUBSYSTEM_COUNT; i++){
+        uint32_t us = (uint32_t) (perf->ticks[i] / PERF_TICKS_PER_US / perf->frames);
+        // render and dma_wait are already part of gpu
+        if (i != PERF_RENDER && i != PERF_DMA_WAIT) accounted_us += us;
+        sprintf(line, "  %-10s %7lu us %3lu%%\r\n", subsystem_names[i], (unsigned long) us,
+            frame_us ? (unsigned long) (100ULL * us / frame_us) : 0UL);
+        perf->write_line(perf->write_line_ctx, line);
+    }
+    uint32_t other_us = frame_us > accounted_us ? frame_us - accounted_us : 0;
+    sprintf(line, "  %-10s %7lu us %3lu%%\r\n", "other", (unsigned long) other_us,
+        frame_us ? (unsigned long) (100ULL * other_us / frame_us) : 0UL);
+    perf->write_line(perf->write_line_ctx, line);
+    
+    memset(perf->ticks, 0, sizeof(perf->ticks));
+    perf->frames = 0;
+    // Restart the window after reporting so the (slow) report itself isn't counted
+    perf->window_start = perf_now();
+}
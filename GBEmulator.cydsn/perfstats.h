@@ -0,0 +1,54 @@
+/*
+Lightweight time-budget instrumentation, enabled with SUBSYSTEM_TIMING_ON
+Accumulates the time spent in each emulator subsystem and reports a per-frame breakdown
+Time comes from the Cortex-M3 DWT cycle counter on the PSoC and from clock_gettime on host
+*/
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+#include "stdint.h"
+#include "stdbool.h"
+
+typedef enum PerfSubsystem {
+    PERF_CPU,        // tick
+    PERF_GPU,        // tick_gpu, including renderLine
+    PERF_RENDER,     // renderLine, including waiting on the DMA
+    PERF_DMA_WAIT,   // spinning on isDmaReady
+    PERF_TIMER,      // tick_timer and tick_serial
+    PERF_MMIO,       // tick_mmio
+    PERF_SUBSYSTEM_COUNT
+} PerfSubsystem;
+
+// A perf_now() value: the PSoC's 32 bit cycle counter, or 64 bits of nanoseconds on the host,
+// which 32 bits would wrap every 4.3s
+#ifdef HOST_BUILD
+typedef uint64_t PerfTicks;
+#else
+typedef uint32_t PerfTicks;
+#endif
+
+typedef struct PerfStats {
+    uint64_t ticks[PERF_SUBSYSTEM_COUNT];  // accumulated over the current report window
+    PerfTicks window_start;                // perf_now() when the window started
+    uint32_t frames;                       // frames completed in the current window
+    uint32_t report_interval_frames;       // a report is made every this many frames
+    // Receives the report, one line at a time
+    void (*write_line)(void* ctx, const char* line);
+    void* write_line_ctx;
+} PerfStats;
+
+// Starts the cycle counter and clears the stats
+// write_line NULL sends the reports over UART_1
+void setup_perf_stats(PerfStats* perf, uint32_t report_interval_frames, void (*write_line)(void* ctx, const char* line), void* ctx);
+// Current time in perf ticks (PERF_TICKS_PER_US per microsecond); wraps around, so only compare differences
+PerfTicks perf_now(void);
+// Starts the cycle counter perf_now reads, without resetting it; setup_perf_stats does this too
+void perf_clock_start(void);
+// Microseconds since the perf_now() value start; good for about a minute at the PSoC's clock, for centuries on the host
+uint32_t perf_us_since(PerfTicks start);
+// Adds the time since start to a subsystem
+static inline void perf_add_since(PerfStats* perf, PerfSubsystem subsystem, PerfTicks start){
+    perf->ticks[subsystem] += (PerfTicks) (perf_now() - start);
+}
+// Called once per completed frame; reports and starts a new window every report_interval_frames
+void perf_frame_done(PerfStats* perf);
+#endif
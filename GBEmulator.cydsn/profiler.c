@@ -0,0 +1,114 @@
+#include "profiler.h"
+#include <project.h>
+#include "stdio.h"
+#include "string.h"
+#ifdef HOST_BUILD
+#include "time.h"
+#endif
+
+// Returns a monotonic host time in ns, or 0 when there is no host clock (on the PSoC)
+static inline uint64_t profiler_clock_ns(void){
+#ifdef HOST_BUILD
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+void reset_profiler(Profiler* profiler){
+    memset(profiler, 0, sizeof(Profiler));
+    profiler->sample_countdown = PROFILER_SAMPLE_INTERVAL;
+}
+
+// Counts pc in the hot pc table
+// When all probed slots are taken, the coldest one is replaced and inherits its count,
+// so pcs that become hot later still rise to the top
+static void count_hot_pc(Profiler* profiler, uint16_t pc){
+    uint32_t slot = (pc * 0x9E37u) & (PROFILER_HOT_PC_SLOTS - 1);
+    HotPc* coldest = &profiler->hot_pcs[slot];
+    int i;
+    for (i = 0; i < PROFILER_HOT_PC_PROBES; i++){
+        HotPc* entry = &profiler->hot_pcs[(slot + i) & (PROFILER_HOT_PC_SLOTS - 1)];
+        if (entry->count == 0 || entry->pc == pc){
+            entry->pc = pc;
+            entry->count++;
+            return;
+        }
+        if (entry->count < coldest->count) coldest = entry;
+    }
+    coldest->pc = pc;
+    coldest->count++;
+}
+
+void profiler_begin(Profiler* profiler, uint16_t pc){
+    profiler->current_pc = pc;
+    if (--profiler->sample_countdown == 0){
+        profiler->sample_start_ns = profiler_clock_ns();
+    }
+}
+
+void profiler_end(Profiler* profiler, bool cb_prefixed, uint8_t opcode, uint8_t cycles_taken){
+    OpcodeProfile* entry = cb_prefixed ? &profiler->cb_opcodes[opcode] : &profiler->opcodes[opcode];
+    entry->count++;
+    if (profiler->sample_countdown == 0){
+        profiler->sample_countdown = PROFILER_SAMPLE_INTERVAL;
+        if (profiler->sample_start_ns){
+            entry->samples++;
+            entry->sampled_ns += profiler_clock_ns() - profiler->sample_start_ns;
+        }
+    }
+    profiler->total_instrs++;
+    profiler->total_cycles += cycles_taken;
+    count_hot_pc(profiler, profiler->current_pc);
+}
+
+static void report_opcodes(OpcodeProfile* opcodes, const char* table, void (*write_line)(void* ctx, const char* line), void* ctx){
+    char line[96];
+    int i;
+    for (i = 0; i < 256; i++){
+        OpcodeProfile* entry = &opcodes[i];
+        if (entry->count == 0) continue;
+        sprintf(line, "%s,0x%02X,%lu,%lu,%llu,%lu\r\n", table, i, (unsigned long) entry->count, (unsigned long) entry->samples,
+            (unsigned long long) entry->sampled_ns, entry->samples ? (unsigned long) (entry->sampled_ns / entry->samples) : 0UL);
+        write_line(ctx, line);
+    }
+}
+
+void profiler_report(Profiler* profiler, void (*write_line)(void* ctx, const char* line), void* ctx){
+    char line[96];
+    sprintf(line, "# total_instrs,%llu\r\n", (unsigned long long) profiler->total_instrs);
+    write_line(ctx, line);
+    sprintf(line, "# total_cycles,%llu\r\n", (unsigned long long) profiler->total_cycles);
+    write_line(ctx, line);
+    write_line(ctx, "table,opcode_or_pc,count,samples,sampled_ns,avg_ns\r\n");
+    report_opcodes(profiler->opcodes, "opcode", write_line, ctx);
+    report_opcodes(profiler->cb_opcodes, "cb_opcode", write_line, ctx);
+    
+    // hot pcs, hottest first (selection sort on a copy; the table is small)
+    static HotPc sorted[PROFILER_HOT_PC_SLOTS];
+    memcpy(sorted, profiler->hot_pcs, sizeof(sorted));
+    int i;
+    for (i = 0; i < PROFILER_HOT_PC_SLOTS; i++){
+        int hottest = i;
+        int j;
+        for (j = i + 1; j < PROFILER_HOT_PC_SLOTS; j++){
+            if (sorted[j].count > sorted[hottest].count) hottest = j;
+        }
+        HotPc tmp = sorted[i];
+        sorted[i] = sorted[hottest];
+        sorted[hottest] = tmp;
+        if (sorted[i].count == 0) break;
+        sprintf(line, "pc,0x%04X,%lu,,,\r\n", sorted[i].pc, (unsigned long) sorted[i].count);
+        write_line(ctx, line);
+    }
+}
+
+static void write_line_uart(void* ctx, const char* line){
+    UART_1_PutString(line);
+}
+
+void profiler_report_uart(Profiler* profiler){
+    profiler_report(profiler, write_line_uart, NULL);
+}
@@ -0,0 +1,51 @@
+/*
+Optional per-opcode execution profiler, hooked into tick when PROFILER_ON is set
+Counts every executed opcode and CB opcode, keeps the hottest PCs in a fixed size table
+and, when a host clock is available, samples how long each handler takes
+*/
+#ifndef PROFILER_H
+#define PROFILER_H
+#include "stdint.h"
+#include "stdbool.h"
+
+#define PROFILER_SAMPLE_INTERVAL 64   // time one in every 64 instructions (host clock only)
+#define PROFILER_HOT_PC_SLOTS 256     // must be a power of 2
+#define PROFILER_HOT_PC_PROBES 8      // slots searched before evicting the coldest one
+
+typedef struct OpcodeProfile {
+    uint32_t count;         // times executed
+    uint32_t samples;       // times timed
+    uint64_t sampled_ns;    // total host time of the timed executions
+} OpcodeProfile;
+
+typedef struct HotPc {
+    uint16_t pc;
+    uint32_t count;         // 0 marks an empty slot
+} HotPc;
+
+typedef struct Profiler {
+    OpcodeProfile opcodes[256];
+    OpcodeProfile cb_opcodes[256];
+    HotPc hot_pcs[PROFILER_HOT_PC_SLOTS];
+    uint64_t total_instrs;
+    uint64_t total_cycles;  // machine cycles spent in instructions (interrupt dispatch not included)
+    
+    // state of the instruction in flight
+    uint16_t current_pc;
+    uint32_t sample_countdown;
+    uint64_t sample_start_ns;
+} Profiler;
+
+// Clears all counters
+void reset_profiler(Profiler* profiler);
+// Called before an instruction is fetched from pc
+void profiler_begin(Profiler* profiler, uint16_t pc);
+// Called once the instruction has executed
+// cb_prefixed selects the CB opcode table for opcode
+void profiler_end(Profiler* profiler, bool cb_prefixed, uint8_t opcode, uint8_t cycles_taken);
+// Writes the profile as CSV, one line at a time, through write_line
+// Columns: table,opcode_or_pc,count,samples,sampled_ns,avg_ns
+void profiler_report(Profiler* profiler, void (*write_line)(void* ctx, const char* line), void* ctx);
+// Same as above, over UART_1
+void profiler_report_uart(Profiler* profiler);
+#endif
@@ -0,0 +1,108 @@
+#include "serial.h"
+#include "emumode.h"
+#include <project.h>
+#include "string.h"
+
+#define SERIAL_RING_MASK (SERIAL_RING_SIZE - 1)
+
+void setup_serial(Serial* serial, Memory* mem, SerialOverflowPolicy policy){
+    memset(serial, 0, sizeof(Serial));
+    serial->mem = mem;
+    serial->out.policy = policy;
+    mem->serial_ring = &serial->out;
+}
+
+bool serial_ring_put(SerialRing* ring, uint8_t data){
+    uint16_t head = ring->head;
+    uint16_t next = (head + 1) & SERIAL_RING_MASK;
+    if (next == ring->tail){
+        ring->overflows++;
+        // only the TX interrupt can make room while the producer waits here
+        if (ring->policy == SERIAL_OVERFLOW_DROP || !ring->uart_isr) return false;
+        while (next == ring->tail);
+    }
+    ring->ring[head] = data;
+    ring->head = next;
+#if SERIAL_TX_ISR_ON
+    if (ring->uart_isr) UART_1_SetTxInterruptMode(UART_1_TX_STS_FIFO_NOT_FULL);
+#endif
+    return true;
+}
+
+int serial_ring_read(SerialRing* ring, uint8_t* out, int max){
+    uint16_t tail = ring->tail;
+    int count = 0;
+    while (count < max && tail != ring->head){
+        out[count++] = ring->ring[tail];
+        tail = (tail + 1) & SERIAL_RING_MASK;
+    }
+    ring->tail = tail;
+    return count;
+}
+
+void serial_drain_uart(SerialRing* ring){
+    uint16_t tail = ring->tail;
+    while (tail != ring->head && (UART_1_ReadTxStatus() & UART_1_TX_STS_FIFO_NOT_FULL)){
+        UART_1_WriteTxData(ring->ring[tail]);
+        tail = (tail + 1) & SERIAL_RING_MASK;
+    }
+    ring->tail = tail;
+}
+
+#if SERIAL_TX_ISR_ON
+static SerialRing* uart_tx_ring;
+
+CY_ISR(uart_tx_handler){
+    serial_drain_uart(uart_tx_ring);
+    // FIFO not full stays set while there is room, so stop asking until the producer puts the next byte
+    // (the producer can't run in between, so no byte is left behind)
+    if (serial_ring_empty(uart_tx_ring)) UART_1_SetTxInterruptMode(0);
+}
+
+void start_serial_uart_isr(SerialRing* ring){
+    uart_tx_ring = ring;
+    ring->uart_isr = true;
+    UART_1_SetTxInterruptMode(0);
+    isr_uart_tx_StartEx(uart_tx_handler);
+    if (!serial_ring_empty(ring)) UART_1_SetTxInterruptMode(UART_1_TX_STS_FIFO_NOT_FULL);
+}
+#endif
+
+static void complete_transfer(Serial* serial, uint8_t received){
+    Memory* mem = serial->mem;
+    mem->sb = received;
+    mem->sc &= ~SC_TRANSFER_START;
+    request_interrupt(mem, INTERRUPT_ENABLE_SERIAL_MASK);
+    serial->waiting = false;
+}
+
+void finish_serial_transfer(Serial* serial){
+    serial->mem->serial_cycles_left = 0;
+    if (serial->linked){
+        // the byte the other side sends comes with the next resolve_serial_link
+        serial->waiting = true;
+        return;
+    }
+    complete_transfer(serial, 0xFF);
+}
+
+SerialLinkState serial_link_state(const Serial* serial){
+    Memory* mem = serial->mem;
+    SerialLinkState state = {0, mem->sb};
+    bool started = mem->sc & SC_TRANSFER_START;
+    // waiting is stale once the game writes SC again, which restarts or cancels the transfer
+    if (started && serial->waiting && mem->serial_cycles_left == 0 && (mem->sc & SC_INTERNAL_CLOCK)){
+        state.flags |= SERIAL_LINK_MASTER_WAITING;
+    }
+    if (started && !(mem->sc & SC_INTERNAL_CLOCK)) state.flags |= SERIAL_LINK_SLAVE_READY;
+    if (started) state.flags |= SERIAL_LINK_BUSY;
+    return state;
+}
+
+void resolve_serial_link(Serial* serial, SerialLinkState mine, SerialLinkState peer){
+    if (mine.flags & SERIAL_LINK_MASTER_WAITING){
+        complete_transfer(serial, (peer.flags & SERIAL_LINK_SLAVE_READY) ? peer.sb : 0xFF);
+    } else if ((mine.flags & SERIAL_LINK_SLAVE_READY) && (peer.flags & SERIAL_LINK_MASTER_WAITING)){
+        complete_transfer(serial, peer.sb);
+    }
+}
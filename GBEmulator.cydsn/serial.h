@@ -0,0 +1,87 @@
+/*
+Serial port: transfer timing, the ring bytes passed through to UART_1 go into, and link cable syncing
+A transfer started with the internal clock (SC = 0x81) takes 8 bits at 8192 Hz, then clears SC bit 7 and
+requests the serial interrupt. The byte being sent is queued in a single producer (write_mem) /
+single consumer (serial_drain_uart) ring, so no emulated memory write waits on the UART
+The consumer is UART_1's TX FIFO not full interrupt when SERIAL_TX_ISR_ON (start_serial_uart_isr),
+otherwise whoever polls serial_drain_uart, e.g. the main loop
+*/
+#ifndef SERIAL_H
+#define SERIAL_H
+#include "memory.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+#define SERIAL_RING_SIZE 256            // bytes, must be a power of 2
+
+// What serial_ring_put does with a byte when the ring is full
+typedef enum SerialOverflowPolicy {
+    SERIAL_OVERFLOW_DROP,   // lose it (counted in overflows)
+    SERIAL_OVERFLOW_BLOCK   // wait for the TX interrupt to make room, e.g. so long test rom logs arrive whole
+                            // (without start_serial_uart_isr nothing else can, so the byte is dropped as above)
+} SerialOverflowPolicy;
+
+typedef struct SerialRing {
+    uint8_t ring[SERIAL_RING_SIZE];
+    volatile uint16_t head;          // only written by the producer
+    volatile uint16_t tail;          // only written by the consumer
+    uint32_t overflows;              // bytes that found the ring full
+    SerialOverflowPolicy policy;
+    bool uart_isr;                   // drained by the TX interrupt (start_serial_uart_isr)
+} SerialRing;
+
+typedef struct Serial {
+    Memory* mem;
+    SerialRing out;                  // bytes sent by the game, on their way to UART_1
+    // Link cable (see host/link_cable.h): a finished transfer waits for the other side instead of shifting in 0xFF
+    bool linked;
+    bool waiting;                    // this side clocked out a byte and waits for resolve_serial_link
+} Serial;
+
+// What one side of a link cable shows the other when they sync
+#define SERIAL_LINK_MASTER_WAITING 0x01 // finished clocking out sb (internal clock)
+#define SERIAL_LINK_SLAVE_READY    0x02 // armed for the other side's clock (SC = 0x80)
+#define SERIAL_LINK_BUSY           0x04 // a transfer is in progress, so the link should sync often
+typedef struct SerialLinkState {
+    uint8_t flags;
+    uint8_t sb;
+} SerialLinkState;
+
+// Initializes the serial port and points mem->serial_ring at its ring
+void setup_serial(Serial* serial, Memory* mem, SerialOverflowPolicy policy);
+// Queues a byte; returns false if it was dropped
+bool serial_ring_put(SerialRing* ring, uint8_t data);
+// Takes up to max bytes out of the ring; returns the number taken
+int serial_ring_read(SerialRing* ring, uint8_t* out, int max);
+// Moves as much of the ring into the UART_1 TX FIFO as fits, without waiting
+// The ring's consumer: call it from one place only, the main loop or (through start_serial_uart_isr) the TX interrupt
+void serial_drain_uart(SerialRing* ring);
+#if SERIAL_TX_ISR_ON
+// Makes isr_uart_tx, on UART_1's TX FIFO not full, the ring's consumer; only one ring can have it
+// serial_ring_put unmasks the interrupt for every byte and the interrupt masks itself once the ring is empty
+void start_serial_uart_isr(SerialRing* ring);
+#endif
+static inline bool serial_ring_empty(const SerialRing* ring){
+    return ring->head == ring->tail;
+}
+
+// Finishes the transfer in progress: unlinked, nothing is connected, so 0xFF is shifted in
+void finish_serial_transfer(Serial* serial);
+// This side's state for the other end of the link
+SerialLinkState serial_link_state(const Serial* serial);
+// Completes whatever transfer the two sides' states allow; both sides call it with the same pair of states
+// A master with no armed slave on the other side shifts in 0xFF
+void resolve_serial_link(Serial* serial, SerialLinkState mine, SerialLinkState peer);
+// processes the next tick of the serial port
+// Takes in the # of machine cycles that elapsed, which can be a whole transfer (SERIAL_TRANSFER_CYCLES);
+// inline, as nearly every call has nothing to do
+static inline void tick_serial(Serial* serial, int delta_machine_cycles){
+    Memory* mem = serial->mem;
+    if (mem->serial_cycles_left == 0) return;
+    if (mem->serial_cycles_left > delta_machine_cycles){
+        mem->serial_cycles_left -= delta_machine_cycles;
+        return;
+    }
+    finish_serial_transfer(serial);
+}
+#endif
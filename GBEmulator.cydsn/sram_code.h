@@ -0,0 +1,26 @@
+/*
+Runs the hottest code and tables from SRAM instead of flash (SRAM_HOT_CODE_ON)
+Flash is read through a small cache with wait states at high clocks, and the big switch based functions
+(run_cycles, fetch_mapped, write_mem, renderLine) don't fit in it. SRAM is read with no wait states.
+SRAM_CODE puts a function in the .ram section and SRAM_TABLE puts a table in a .data.sram_table_* section.
+The generated linker script (cm3gcc.ld) already collects both into .data, so the startup code copies them
+from flash into SRAM before main like any initialized variable, and no custom linker script is needed
+SRAM is out of reach of a plain bl from flash, so SRAM_CODE is also long_call and has to be on the
+declaration as well as the definition. Calls from SRAM back into flash get linker veneers
+Every byte placed comes out of the 64KB the emulator's state also lives in:
+host/sramreport ranks the candidates by profile and lists what a PSoC build placed (see host/Makefile)
+*/
+#ifndef SRAM_CODE_H
+#define SRAM_CODE_H
+#include "emumode.h"
+
+#if SRAM_HOT_CODE_ON && !defined(HOST_BUILD)
+#define SRAM_CODE __attribute__((section(".ram"), long_call))
+// Each table gets its own section: a const table can't share one with code, and .data.* is for data
+#define SRAM_TABLE(name) __attribute__((section(".data.sram_table_" #name)))
+#else
+#define SRAM_CODE
+#define SRAM_TABLE(name)
+#endif
+
+#endif
@@ -10,6 +10,9 @@
  * ========================================
 */
 #include "tft.h"
+#include "perfstats.h"
+
+static PerfTicks tft_display_on_time;   // perf_now() at the Display ON command of tftStartBegin
 void setDClow(void){
     DC_Write(0x00);
 }
@@ -91,6 +94,16 @@ void readM8_a1(uint8 *pData, int N)
 // this function must be called to initializes the TFT
 //==============================================================
 void tftStart(void)
+{
+    tftStartBegin();
+    tftStartFinish();
+}
+
+//==============================================================
+// tftStartBegin()
+// sends the initialization commands, without waiting for them to take effect
+//==============================================================
+void tftStartBegin(void)
 {
     write8_a0(0x01);         			// send Software Reset Command (must wait at least 5ms after command)
     CyDelay(10);
@@ -100,9 +113,53 @@ void tftStart(void)
     write8_a1(0x55);
     write8_a0(0x11);         			// send Sleep Out command
     write8_a0(0x29);         			// send Display ON command
-    CyDelay(250);            			// delay to allow all changes to take effect	
+    perf_clock_start();
+    tft_display_on_time = perf_now();
+}
+
+//==============================================================
+// tftStartFinish()
+// waits out whatever is left of the TFT_SETTLE_MS after tftStartBegin
+//==============================================================
+void tftStartFinish(void)
+{
+    while (perf_us_since(tft_display_on_time) < TFT_SETTLE_MS * 1000UL){}   // allow all changes to take effect
+}
+
+//==============================================================
+// tftSetWindow()
+// sets the column and page range the next Memory Write fills
+//==============================================================
+void tftSetWindow(uint16 SC, uint16 EC, uint16 SP, uint16 EP)
+{
+    write8_a0(0x2A);                 	// send Column Address Set command
+    write8_a1(SC >> 8);                 // set SC[15:0]
+    write8_a1(SC & 0x00FF);
+    write8_a1(EC >> 8);                 // set EC[15:0]
+    write8_a1(EC & 0x00FF);
+    write8_a0(0x2B);                 	// send Page Address Set command
+    write8_a1(SP >> 8);                 // set SP[15:0]
+    write8_a1(SP & 0x00FF);
+    write8_a1(EP >> 8);                 // set EP[15:0]
+    write8_a1(EP & 0x00FF);
+}
+
+//==============================================================
+// tftClear()
+// fills the whole panel with black, e.g. around a smaller window
+//==============================================================
+void tftClear(void)
+{
+    tftSetWindow(0, TFT_WIDTH - 1, 0, TFT_HEIGHT - 1);
+    write8_a0(0x2C);                    // send Memory Write command
+    uint32_t i;
+    for (i = 0; i < 2 * (uint32_t) TFT_WIDTH * TFT_HEIGHT; i++){
+        write8_a1(0x00);
+    }
+    write8_a0(0x00);                    // send NOP command to end the writing process
 }
 
+static uint32_t dmaBurstLength;
 
 void setupDma(uint8_t* dma_buff, uint32_t burstLength){
      /* Disable the TX interrupt of SPIM */
@@ -117,11 +174,15 @@ void setupDma(uint8_t* dma_buff, uint32_t burstLength){
     //Allocate TD to transfer x bytes
     txTD = CyDmaTdAllocate();
    
+    //Allocate TD to send the line again, for scaled output
+    txRepeatTD = CyDmaTdAllocate();
+    
     //Allocate TD to disable the SPI Master TX interrupt
     InterruptControlTD = CyDmaTdAllocate();
    
     // txTD = From the memory to the SPIM 
     CyDmaTdSetAddress(txTD, LO16(((uint32)&dma_buff[0])), LO16(((uint32) SPIM_1_TXDATA_PTR)));
+    CyDmaTdSetAddress(txRepeatTD, LO16(((uint32)&dma_buff[0])), LO16(((uint32) SPIM_1_TXDATA_PTR)));
    
     // Set the source address as variable 'InterruptControl' which stores the value 0 to disable the SPI_INT_ON_TX_EMPTY
 	// and the destination is Control_Reg_SPIM_ctrl_reg__CONTROL_REG 
@@ -130,6 +191,10 @@ void setupDma(uint8_t* dma_buff, uint32_t burstLength){
     // Set TD_tx transfer count as "burstLength" to transfer the data packet
     // Next Td as InterruptControlTD, and auto increment source address after each transaction 
     CyDmaTdSetConfiguration(txTD,burstLength,InterruptControlTD, TD_INC_SRC_ADR );
+    dmaBurstLength = burstLength;
+    
+    // txRepeatTD sends the same data again; startDmaTransfer puts it after txTD when a line is sent twice
+    CyDmaTdSetConfiguration(txRepeatTD,burstLength,InterruptControlTD, TD_INC_SRC_ADR );
    
     // Set InterruptControlTD with transfer count 1, next TD as txTD
     // Also enable the Terminal Output . This can be used to monitor whether transfer is complete 
@@ -146,7 +211,9 @@ void setupDma(uint8_t* dma_buff, uint32_t burstLength){
     CyDmaChEnable(txChannel,1);
 }
 
-void startDmaTransfer(void){
+void startDmaTransfer(uint8_t sends){
+    // The channel is idle at txTD here, so where txTD goes next can be changed safely
+    CyDmaTdSetConfiguration(txTD, dmaBurstLength, sends > 1 ? txRepeatTD : InterruptControlTD, TD_INC_SRC_ADR);
     SPIM_1_TX_STATUS_MASK_REG|=(SPIM_1_INT_ON_TX_EMPTY); 
 }
 
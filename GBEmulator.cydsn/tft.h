@@ -14,14 +14,28 @@
 #include "project.h"
 #include "stdbool.h"
 
+#define TFT_WIDTH 240               // panel size in the orientation tftStart sets up
+#define TFT_HEIGHT 320
+#define TFT_SPI_BITRATE 16000000    // SPIM_1 bit rate (TopDesign)
+#define TFT_SETTLE_MS 250           // after Display ON, before the panel takes pixels
+
 void write8_a0(uint8 data);
 void write8_a1(uint8 data);
 void writeM8_a1(uint8 *pData, int N);
 uint8 read8_a1(void);
 void readM8_a1(uint8 *pData, int N);
+// Initializes the TFT and waits until it is ready for pixels
 void tftStart(void);
+// Same as tftStart in two halves: Begin sends the commands, Finish waits out the rest of TFT_SETTLE_MS,
+// so other setup can run in between. Only commands (like tftSetWindow) can go to the panel before Finish
+void tftStartBegin(void);
+void tftStartFinish(void);
 void setDClow(void);
 void setDChigh(void);
+// Sets the area the next Memory Write command fills, from column SC to EC and page SP to EP
+void tftSetWindow(uint16 SC, uint16 EC, uint16 SP, uint16 EP);
+// Fills the whole panel with black
+void tftClear(void);
 
 /* DMA Configuration for DMA_TX */
 #define DMA_TX_BYTES_PER_BURST      1
@@ -30,6 +44,7 @@ void setDChigh(void);
 /* Variable declarations for DMA_TX*/
 uint8 txChannel;
 uint8 txTD;
+uint8 txRepeatTD;   // sends the line buffer a second time, for scaled output
 
 /* Variable declarations for InterruptControl Td*/
 uint8_t InterruptControlTD;
@@ -43,8 +58,9 @@ void setupDma(uint8_t* dma_buff, uint32_t burstLength);
 
 // Returns true if DMA is ready for another round
 bool isDmaReady(void);
-// Starts a new DMA transfer
-void startDmaTransfer(void);
+// Starts a new DMA transfer that sends dma_buff sends (1 or 2) times in a row
+// Repeating a line costs SPI time only; the DMA goes over the same buffer again
+void startDmaTransfer(uint8_t sends);
 
 #endif
 
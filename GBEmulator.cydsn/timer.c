@@ -2,6 +2,19 @@
 void setup_timer(Timer* timer, Memory* mem){
     timer->mem = mem;
 }
+// Base clock ticks (every 4 m-cycles) per TIMA increment, by TAC bits 1-0
+static const int base_clock_thresholds[4] = {64, 1, 4, 16};
+
+int timer_cycles_to_event(Timer* timer){
+    int ticks = 16 - timer->divclock;
+    if (timer->mem->timer_control & TIMER_CONTROL_ENABLE_MASK){
+        int tima_ticks = base_clock_thresholds[timer->mem->timer_control & 3] - timer->baseclock;
+        if (tima_ticks < ticks) ticks = tima_ticks;
+    }
+    int cycles = ticks * 4 - timer->internal_clock;
+    return cycles > 0 ? cycles : 1;
+}
+
 void tick_timer(Timer* timer, uint8_t delta_machine_cycles){
     timer->internal_clock += delta_machine_cycles;
     // Keep ticking the timer until the internal clock < 4
@@ -25,7 +38,7 @@ void tick_timer(Timer* timer, uint8_t delta_machine_cycles){
         //   10: CPU Clock / 64   =  65536 Hz  = once every 4*4 m-cycles = 4 timer.base_clock s
         //   11: CPU Clock / 256  =  16384 Hz  = once every 4*16 m-cycles = 16 timer.base_clock s
         
-        if (timer_control & 100){
+        if (timer_control & TIMER_CONTROL_ENABLE_MASK){
             timer->baseclock++; // the fastest base clock speed is once every 4 m-cycles
             int base_clock_threshold;
             switch (timer_control & 3){
@@ -49,7 +62,7 @@ void tick_timer(Timer* timer, uint8_t delta_machine_cycles){
                 
                 if (timer->mem->timer_counter == 0xFF) {
                     // This increment will cause an overflow; request interrupt
-                    timer->mem->interrupt_flag |= INTERRUPT_ENABLE_TIMER_MASK;
+                    request_interrupt(timer->mem, INTERRUPT_ENABLE_TIMER_MASK);
                     // And refill wil the timer modulo value
                     timer->mem->timer_counter = timer->mem->timer_modulo;
                 } else {
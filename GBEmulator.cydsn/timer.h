@@ -11,6 +11,9 @@ typedef struct Timer {
 // Initializes a new timer
 void setup_timer(Timer* timer, Memory* mem);
 
+// Machine cycles until DIV or TIMA next changes
+int timer_cycles_to_event(Timer* timer);
+
 // processes the next tick of the timer
 // Takes in the # of machine cycles that elapsed
 void tick_timer(Timer* timer, uint8_t delta_machine_cycles);
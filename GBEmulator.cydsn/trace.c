@@ -0,0 +1,196 @@
+#include "trace.h"
+#include "project.h"
+#include "stdio.h"
+#include "string.h"
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+void setup_trace(TraceEncoder* trace){
+    memset(trace, 0, sizeof(TraceEncoder));
+    trace->need_keyframe = true;
+}
+
+void trace_fill_record(TraceRecord* record, Cpu* cpu, uint8_t cycle_delta){
+    Registers* reg = &cpu->reg;
+    record->pc = reg->pc;
+    record->sp = reg->sp;
+    record->regs[TRACE_REG_A] = reg->a;
+    record->regs[TRACE_REG_F] = reg->f;
+    record->regs[TRACE_REG_B] = reg->b;
+    record->regs[TRACE_REG_C] = reg->c;
+    record->regs[TRACE_REG_D] = reg->d;
+    record->regs[TRACE_REG_E] = reg->e;
+    record->regs[TRACE_REG_H] = reg->h;
+    record->regs[TRACE_REG_L] = reg->l;
+    for (int i = 0; i < 4; i++){
+        record->opcode_bytes[i] = fetch(cpu->mem, reg->pc + i, cpu->inBios);
+    }
+    record->cycle_delta = cycle_delta;
+    record->flags = (cpu->inBios ? TRACE_FLAG_IN_BIOS : 0) | (reg->ime ? TRACE_FLAG_IME : 0);
+}
+
+// Encodes record against prev into out, returns the encoded size
+static int encode_record(const TraceRecord* record, const TraceRecord* prev, bool keyframe, uint8_t* out){
+    int size = 2;   // header and reg mask
+    uint8_t header = 0;
+    uint8_t reg_mask = 0;
+    for (int i = 0; i < TRACE_REG_COUNT; i++){
+        if (keyframe || record->regs[i] != prev->regs[i]){
+            if (!keyframe){
+                reg_mask |= 1 << i;
+            }
+            out[size++] = record->regs[i];
+        }
+    }
+    if (keyframe || record->sp != prev->sp){
+        header |= TRACE_HDR_SP;
+        out[size++] = record->sp & 0xFF;
+        out[size++] = record->sp >> 8;
+    }
+
+    // A short forward step whose opcode bytes overlap the previous record's only needs the new bytes
+    uint16_t pc_step = record->pc - prev->pc;
+    bool sequential = !keyframe && pc_step < 4 &&
+        memcmp(record->opcode_bytes, prev->opcode_bytes + pc_step, 4 - pc_step) == 0;
+    if (sequential){
+        header |= pc_step;
+    } else {
+        header |= TRACE_HDR_PC;
+        out[size++] = record->pc & 0xFF;
+        out[size++] = record->pc >> 8;
+    }
+    if (keyframe || record->flags != prev->flags){
+        header |= TRACE_HDR_FLAGS;
+        out[size++] = record->flags;
+    }
+    for (int i = sequential ? 4 - pc_step : 0; i < 4; i++){
+        out[size++] = record->opcode_bytes[i];
+    }
+    out[size++] = record->cycle_delta;
+
+    if (keyframe){
+        // No reg mask in a keyframe, every register is present
+        header |= TRACE_HDR_KEYFRAME | TRACE_HDR_SP | TRACE_HDR_PC | TRACE_HDR_FLAGS;
+        memmove(out + 1, out + 2, size - 2);
+        size--;
+    } else {
+        out[1] = reg_mask;
+    }
+    out[0] = header;
+    return size;
+}
+
+void trace_instruction(TraceEncoder* trace, Cpu* cpu, uint8_t cycle_delta){
+    TraceRecord record;
+    uint8_t encoded[TRACE_MAX_RECORD_SIZE];
+    trace_fill_record(&record, cpu, cycle_delta);
+
+    bool keyframe = trace->need_keyframe || trace->records_since_keyframe >= TRACE_KEYFRAME_INTERVAL;
+    if (trace->dropped_since_last){
+        record.flags |= TRACE_FLAG_DROPPED;
+    }
+    int size = encode_record(&record, &trace->prev, keyframe, encoded);
+
+    uint16_t head = trace->head;
+    uint16_t free_space = (trace->tail - head - 1) & TRACE_RING_MASK;
+    if (size > free_space){
+        // Never block the emulator; the decoder resyncs on the keyframe that follows
+        trace->dropped++;
+        trace->dropped_since_last = true;
+        trace->need_keyframe = true;
+        return;
+    }
+    for (int i = 0; i < size; i++){
+        trace->ring[(head + i) & TRACE_RING_MASK] = encoded[i];
+    }
+    trace->head = (head + size) & TRACE_RING_MASK;
+
+    trace->prev = record;
+    trace->records_since_keyframe = keyframe ? 0 : trace->records_since_keyframe + 1;
+    trace->need_keyframe = false;
+    trace->dropped_since_last = false;
+}
+
+int trace_read(TraceEncoder* trace, uint8_t* out, int max){
+    uint16_t tail = trace->tail;
+    int count = 0;
+    while (count < max && tail != trace->head){
+        out[count++] = trace->ring[tail];
+        tail = (tail + 1) & TRACE_RING_MASK;
+    }
+    trace->tail = tail;
+    return count;
+}
+
+void trace_drain_uart(TraceEncoder* trace){
+    uint16_t tail = trace->tail;
+    while (tail != trace->head && (UART_1_ReadTxStatus() & UART_1_TX_STS_FIFO_NOT_FULL)){
+        UART_1_WriteTxData(trace->ring[tail]);
+        tail = (tail + 1) & TRACE_RING_MASK;
+    }
+    trace->tail = tail;
+}
+
+int trace_decode(TraceDecoder* decoder, const uint8_t* data, int len, TraceRecord* out){
+    if (len < 1){
+        return 0;
+    }
+    uint8_t header = data[0];
+    bool keyframe = header & TRACE_HDR_KEYFRAME;
+    int pos = 1;
+    uint8_t reg_mask = 0xFF;
+    if (!keyframe){
+        if (len < 2){
+            return 0;
+        }
+        reg_mask = data[pos++];
+    }
+    uint16_t pc_step = header & TRACE_HDR_PC_STEP;
+    int opcode_count = (header & TRACE_HDR_PC) ? 4 : pc_step;
+    int size = pos + __builtin_popcount(reg_mask) + ((header & TRACE_HDR_SP) ? 2 : 0) +
+        ((header & TRACE_HDR_PC) ? 2 : 0) + ((header & TRACE_HDR_FLAGS) ? 1 : 0) + opcode_count + 1;
+    if (len < size){
+        return 0;
+    }
+    if (!keyframe && !decoder->synced){
+        return size;
+    }
+
+    TraceRecord record = decoder->prev;
+    for (int i = 0; i < TRACE_REG_COUNT; i++){
+        if (reg_mask & (1 << i)){
+            record.regs[i] = data[pos++];
+        }
+    }
+    if (header & TRACE_HDR_SP){
+        record.sp = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+    }
+    if (header & TRACE_HDR_PC){
+        record.pc = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+    } else {
+        record.pc += pc_step;
+        memmove(record.opcode_bytes, record.opcode_bytes + pc_step, 4 - pc_step);
+    }
+    if (header & TRACE_HDR_FLAGS){
+        record.flags = data[pos++];
+    }
+    for (int i = 4 - opcode_count; i < 4; i++){
+        record.opcode_bytes[i] = data[pos++];
+    }
+    record.cycle_delta = data[pos++];
+
+    decoder->prev = record;
+    decoder->synced = true;
+    *out = record;
+    return size;
+}
+
+void trace_fmt_record(char* returnBuffer, const TraceRecord* record){
+    const uint8_t* r = record->regs;
+    sprintf(returnBuffer, "A: %02X F: %02X B: %02X C: %02X D: %02X E: %02X H: %02X L: %02X SP: %04X PC: 00:%04X (%02X %02X %02X %02X)\n",
+    r[TRACE_REG_A], r[TRACE_REG_F], r[TRACE_REG_B], r[TRACE_REG_C], r[TRACE_REG_D], r[TRACE_REG_E], r[TRACE_REG_H], r[TRACE_REG_L], record->sp, record->pc,
+    record->opcode_bytes[0], record->opcode_bytes[1], record->opcode_bytes[2], record->opcode_bytes[3]
+    );
+}
@@ -0,0 +1,85 @@
+/*
+Compact binary cpu trace, a cheap replacement for the sprintf based debug_fmt_cpu_trace
+Each instruction is described by a fixed size TraceRecord, which is delta-encoded against
+the previous record into a ring buffer. The ring is drained to UART_1 without blocking
+and decoded back into the Gameboy-Doctor text format on the host (host/build/bintrace)
+
+Encoded record layout:
+    header        TRACE_HDR_* bits; when TRACE_HDR_PC is clear the low nibble is the pc step
+    reg mask      which of A F B C D E H L follow (omitted in keyframes, where all do)
+    regs          changed registers, in A F B C D E H L order
+    sp            2 bytes little endian, if TRACE_HDR_SP (always in keyframes)
+    pc            2 bytes little endian, if TRACE_HDR_PC (always in keyframes)
+    flags         if TRACE_HDR_FLAGS (always in keyframes)
+    opcode bytes  all 4 bytes at pc, or only the last "pc step" of them when the rest
+                  are the same as the previous record's
+    cycle delta   machine cycles taken by the previous instruction
+*/
+#ifndef TRACE_H
+#define TRACE_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "cpu.h"
+
+#define TRACE_RING_SIZE 2048            // bytes, must be a power of 2
+#define TRACE_KEYFRAME_INTERVAL 256     // a full record is sent at least this often
+#define TRACE_MAX_RECORD_SIZE 20
+
+#define TRACE_HDR_KEYFRAME 0x80
+#define TRACE_HDR_SP       0x40
+#define TRACE_HDR_PC       0x20
+#define TRACE_HDR_FLAGS    0x10
+#define TRACE_HDR_PC_STEP  0x0F
+
+#define TRACE_FLAG_IN_BIOS 0x01
+#define TRACE_FLAG_IME     0x02
+#define TRACE_FLAG_DROPPED 0x04         // records were dropped right before this one (ring was full)
+
+#define TRACE_REG_COUNT 8
+enum { TRACE_REG_A, TRACE_REG_F, TRACE_REG_B, TRACE_REG_C, TRACE_REG_D, TRACE_REG_E, TRACE_REG_H, TRACE_REG_L };
+
+// The cpu state right before an instruction executes
+typedef struct TraceRecord {
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t regs[TRACE_REG_COUNT];   // A F B C D E H L
+    uint8_t opcode_bytes[4];         // memory at pc .. pc + 3
+    uint8_t cycle_delta;             // machine cycles taken by the previous instruction
+    uint8_t flags;                   // TRACE_FLAG_*
+} TraceRecord;
+
+typedef struct TraceEncoder {
+    TraceRecord prev;                // last record written to the ring
+    uint16_t records_since_keyframe;
+    bool need_keyframe;
+    bool dropped_since_last;
+    uint32_t dropped;                // records lost because the ring was full
+    // Single producer (the emulator) / single consumer (the drain) byte ring
+    uint8_t ring[TRACE_RING_SIZE];
+    volatile uint16_t head;          // only written by the producer
+    volatile uint16_t tail;          // only written by the consumer
+} TraceEncoder;
+
+typedef struct TraceDecoder {
+    TraceRecord prev;
+    bool synced;                     // a keyframe has been seen
+} TraceDecoder;
+
+void setup_trace(TraceEncoder* trace);
+// Fills record with the state of cpu before its next instruction
+void trace_fill_record(TraceRecord* record, Cpu* cpu, uint8_t cycle_delta);
+// Records the state of cpu before its next instruction
+// cycle_delta is the number of machine cycles the previous instruction took
+void trace_instruction(TraceEncoder* trace, Cpu* cpu, uint8_t cycle_delta);
+// Takes up to max bytes of encoded trace out of the ring; returns the number taken
+int trace_read(TraceEncoder* trace, uint8_t* out, int max);
+// Moves as much of the ring into the UART_1 TX FIFO as fits, without waiting
+void trace_drain_uart(TraceEncoder* trace);
+
+// Decodes the record at the start of data into out
+// Returns the bytes used, or 0 if data holds only part of a record
+// Records before the first keyframe are skipped: out is only written once decoder->synced is set
+int trace_decode(TraceDecoder* decoder, const uint8_t* data, int len, TraceRecord* out);
+// Formats a record the same way as debug_fmt_cpu_trace, with a plain \n line ending
+void trace_fmt_record(char* returnBuffer, const TraceRecord* record);
+#endif
@@ -0,0 +1,146 @@
+/*
+Captures and decodes the binary cpu trace from trace.h
+usage: bintrace -d in.bin [-o out.txt]
+       bintrace [-r rom_id] [-n instrs] [-s start_pc] [-t] [-o out]
+    -d  decode a binary trace (e.g. captured from UART_1) into the Gameboy-Doctor text format
+    -r  run one of the test roms in rom_table.h instead of the rom built into rom.c
+    -n  number of instructions to trace (default 100000)
+    -s  only start tracing once pc reaches start_pc (hex, default 0100 like TRACE_BINARY_START_PC)
+    -t  write the text trace directly instead of the binary one
+    -o  output file (default stdout)
+*/
+#include "emulator.h"
+#include "trace.h"
+#include "rom_table.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+
+static Emulator emu;
+static TraceEncoder trace;
+
+static void discard_serial(void* ctx, uint8_t data){
+}
+
+static int decode_file(const char* in_path, FILE* out){
+    FILE* in = fopen(in_path, "rb");
+    if (!in){
+        perror(in_path);
+        return 1;
+    }
+    TraceDecoder decoder = {0};
+    TraceRecord record;
+    char line[100];
+    uint8_t data[4096];
+    int len = 0;
+    unsigned long records = 0, dropped_gaps = 0, skipped_bytes = 0;
+    size_t got;
+    while ((got = fread(data + len, 1, sizeof(data) - len, in)) > 0 || len > 0){
+        len += got;
+        int pos = 0;
+        int used;
+        while ((used = trace_decode(&decoder, data + pos, len - pos, &record)) > 0){
+            pos += used;
+            if (!decoder.synced){
+                skipped_bytes += used;
+                continue;
+            }
+            if (record.flags & TRACE_FLAG_DROPPED){
+                dropped_gaps++;
+                fputs("# records dropped here\n", out);
+            }
+            trace_fmt_record(line, &record);
+            fputs(line, out);
+            records++;
+        }
+        len -= pos;
+        memmove(data, data + pos, len);
+        if (got == 0){
+            break;   // trailing partial record
+        }
+    }
+    fclose(in);
+    fprintf(stderr, "%lu records, %lu gaps from dropped records, %lu bytes before the first keyframe, %d trailing bytes\n",
+        records, dropped_gaps, skipped_bytes, len);
+    return 0;
+}
+
+int main(int argc, char** argv){
+    const uint8_t* cartridge = NULL;
+    const char* decode_path = NULL;
+    const char* out_path = NULL;
+    unsigned long num_instrs = 100000;
+    uint16_t start_pc = 0x0100;
+    bool text = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:n:s:to:")) != -1){
+        switch (opt){
+            case 'd': decode_path = optarg; break;
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'n': num_instrs = strtoul(optarg, NULL, 10); break;
+            case 's': start_pc = strtoul(optarg, NULL, 16); break;
+            case 't': text = true; break;
+            case 'o': out_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s -d in.bin [-o out.txt]\n"
+                    "       %s [-r rom_id] [-n instrs] [-s start_pc] [-t] [-o out]\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "wb") : stdout;
+    if (!out){
+        perror(out_path);
+        return 1;
+    }
+    if (decode_path){
+        int result = decode_file(decode_path, out);
+        if (out != stdout) fclose(out);
+        return result;
+    }
+
+    if (!setup_emulator(&emu, cartridge)){
+        fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+        return 1;
+    }
+    set_frame_sink(&emu.gpu, FRAME_SINK_NULL, NULL);
+    emu.mem.serial_hook = discard_serial;
+    setup_trace(&trace);
+    uint8_t last_cycles = 0;
+    bool tracing = false;
+    unsigned long traced = 0;
+    unsigned long bytes = 0;
+    uint8_t data[TRACE_RING_SIZE];
+    char line[100];
+    while (traced < num_instrs){
+        if (tracing || emu.cpu.reg.pc >= start_pc){
+            tracing = true;
+            traced++;
+            if (text){
+                TraceRecord record;
+                trace_fill_record(&record, &emu.cpu, last_cycles);
+                trace_fmt_record(line, &record);
+                fputs(line, out);
+            } else {
+                trace_instruction(&trace, &emu.cpu, last_cycles);
+                int len = trace_read(&trace, data, sizeof(data));
+                fwrite(data, 1, len, out);
+                bytes += len;
+            }
+        }
+        last_cycles = tick_emulator(&emu);
+    }
+    if (!text){
+        fprintf(stderr, "%lu records, %lu bytes (%.2f bytes/record), %lu dropped\n",
+            traced, bytes, (double)bytes / traced, (unsigned long)trace.dropped);
+    }
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,405 @@
+/*
+Differential fuzzer for the cpu
+Runs random register/memory states through single instructions and short random programs on
+two builds of cpu.c, instruction_set.h and memory.c, and compares the registers, cycles taken,
+serial output and every byte of Memory afterwards. Mismatches are minimized before being reported
+usage: cpufuzz [-n cases] [-p programs] [-l length] [-s seed] [-k]
+    -n  single instruction cases to run (default 256000, every opcode and CB opcode equally often)
+    -p  random programs to run (default 50000)
+    -l  longest random program, in instructions (default 64)
+    -s  random seed (default 1)
+    -k  keep going after the first mismatch
+
+The "reference" core is the same sources built again with FUZZ_REF_FLAGS and its symbols
+prefixed with ref_ (see the Makefile) and run with tick; the "optimized" core is the normal host build,
+run through run_cycles one instruction at a time so its pinned fetch loop is what gets compared
+*/
+#include "cpu.h"
+#include "memory.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "stddef.h"
+#include "time.h"
+#include "unistd.h"
+
+#define SERIAL_LOG_SIZE 16
+#define MAX_PROGRAM_LENGTH 1024
+
+int ref_tick(Cpu* cpu);
+void ref_sync_interrupt_check(Cpu* cpu);
+
+typedef int (*TickFunction)(Cpu* cpu);
+typedef void (*SyncFunction)(Cpu* cpu);
+
+typedef struct FuzzCase {
+    Registers reg;
+    int num_instrs;               // instructions to run
+    uint8_t rom[ROM_END];         // cartridge
+    uint8_t eram[EXTERNAL_RAM_SIZE];
+    Memory mem;                   // everything else; mem.rom and mem.eram are pointed at the arrays above when run
+} FuzzCase;
+
+typedef struct SerialLog {
+    int count;
+    uint8_t data[SERIAL_LOG_SIZE];
+} SerialLog;
+
+typedef struct CoreResult {
+    Cpu cpu;
+    Memory mem;
+    uint8_t rom[ROM_END];         // writes to rom must not happen, but are checked for all the same
+    uint8_t eram[EXTERNAL_RAM_SIZE];
+    unsigned long cycles;
+    SerialLog serial;
+} CoreResult;
+
+// Where the parts of Memory that mirror the address space live, for naming a differing byte
+typedef struct MemoryRegion {
+    const char* name;
+    size_t offset;
+    size_t size;
+    uint16_t address;
+} MemoryRegion;
+
+static const MemoryRegion regions[] = {
+    {"wram", offsetof(Memory, wram), WRAM_SIZE, WRAM_START},
+    {"vram", offsetof(Memory, vram), VRAM_SIZE, VRAM_START},
+    {"oam", offsetof(Memory, oam), OAM_SIZE, OAM_START},
+    {"zero_page", offsetof(Memory, zero_page), ZERO_PAGE_SIZE, ZERO_PAGE_START},
+};
+#define NUM_REGIONS (sizeof(regions) / sizeof(regions[0]))
+// Everything in Memory between rom and serial_hook is emulated state
+#define MEMORY_STATE_START offsetof(Memory, wram)
+#define MEMORY_STATE_END offsetof(Memory, serial_hook)
+
+static uint64_t rng_state;
+
+static uint32_t rng(void){
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (rng_state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static void fill_random(uint8_t* data, size_t size){
+    size_t i;
+    for (i = 0; i + 4 <= size; i += 4){
+        uint32_t value = rng();
+        memcpy(data + i, &value, 4);
+    }
+    for (; i < size; i++){
+        data[i] = rng();
+    }
+}
+
+static void log_serial(void* ctx, uint8_t data){
+    SerialLog* log = ctx;
+    if (log->count < SERIAL_LOG_SIZE){
+        log->data[log->count] = data;
+    }
+    log->count++;
+}
+
+static void run_case(const FuzzCase* fuzz_case, TickFunction tick_function, SyncFunction sync_function, CoreResult* result){
+    memcpy(result->rom, fuzz_case->rom, ROM_END);
+    memcpy(result->eram, fuzz_case->eram, EXTERNAL_RAM_SIZE);
+    result->mem = fuzz_case->mem;
+    result->mem.rom = result->rom;
+    result->mem.eram = result->eram;
+    result->mem.eram_size = EXTERNAL_RAM_SIZE;
+    result->mem.serial_hook = log_serial;
+    result->mem.serial_hook_ctx = &result->serial;
+    result->serial.count = 0;
+    memset(&result->cpu, 0, sizeof(Cpu));
+    result->cpu.mem = &result->mem;
+    result->cpu.reg = fuzz_case->reg;
+    result->cpu.inBios = false;
+    sync_function(&result->cpu);
+    result->cycles = 0;
+    for (int i = 0; i < fuzz_case->num_instrs; i++){
+        result->cycles += tick_function(&result->cpu);
+    }
+}
+
+static bool registers_equal(const Registers* a, const Registers* b){
+    return a->af == b->af && a->bc == b->bc && a->de == b->de && a->hl == b->hl &&
+        a->sp == b->sp && a->pc == b->pc && a->ime == b->ime && a->ime_enable_req == b->ime_enable_req;
+}
+
+static bool results_equal(const CoreResult* a, const CoreResult* b){
+    return registers_equal(&a->cpu.reg, &b->cpu.reg) &&
+        a->cpu.inBios == b->cpu.inBios &&
+        a->cycles == b->cycles &&
+        a->serial.count == b->serial.count &&
+        memcmp(a->serial.data, b->serial.data, SERIAL_LOG_SIZE) == 0 &&
+        memcmp((const uint8_t*)&a->mem + MEMORY_STATE_START, (const uint8_t*)&b->mem + MEMORY_STATE_START,
+            MEMORY_STATE_END - MEMORY_STATE_START) == 0 &&
+        memcmp(a->rom, b->rom, ROM_END) == 0 &&
+        memcmp(a->eram, b->eram, EXTERNAL_RAM_SIZE) == 0;
+}
+
+static CoreResult ref_result, opt_result;
+
+// run_cycles always runs one instruction, so a budget of 0 runs exactly one (even HALT and STOP,
+// which take 0 cycles here)
+static int run_one_instruction_batch(Cpu* cpu){
+    return run_cycles(cpu, 0);
+}
+
+static bool case_fails(const FuzzCase* fuzz_case){
+    run_case(fuzz_case, ref_tick, ref_sync_interrupt_check, &ref_result);
+    run_case(fuzz_case, run_one_instruction_batch, sync_interrupt_check, &opt_result);
+    return !results_equal(&ref_result, &opt_result);
+}
+
+// Tries setting size bytes at data to zero, keeps the change if the case still fails
+static bool try_zero(FuzzCase* fuzz_case, uint8_t* data, size_t size){
+    uint8_t saved[256];
+    bool all_zero = true;
+    for (size_t i = 0; i < size; i++){
+        if (data[i]) all_zero = false;
+    }
+    if (all_zero){
+        return true;
+    }
+    memcpy(saved, data, size);
+    memset(data, 0, size);
+    if (case_fails(fuzz_case)){
+        return true;
+    }
+    memcpy(data, saved, size);
+    return false;
+}
+
+// Zeroes as much of data as possible: 256 byte chunks first, then single bytes of the chunks that matter
+static void minimize_bytes(FuzzCase* fuzz_case, uint8_t* data, size_t size){
+    for (size_t chunk = 0; chunk < size; chunk += 256){
+        size_t chunk_size = size - chunk < 256 ? size - chunk : 256;
+        if (!try_zero(fuzz_case, data + chunk, chunk_size)){
+            for (size_t i = 0; i < chunk_size; i++){
+                try_zero(fuzz_case, data + chunk + i, 1);
+            }
+        }
+    }
+}
+
+static void minimize(FuzzCase* fuzz_case){
+    // Fewest instructions first, everything after the first divergence is noise
+    for (int n = 1; n < fuzz_case->num_instrs; n++){
+        int num_instrs = fuzz_case->num_instrs;
+        fuzz_case->num_instrs = n;
+        if (case_fails(fuzz_case)) break;
+        fuzz_case->num_instrs = num_instrs;
+    }
+    uint8_t* reg_bytes[] = {
+        &fuzz_case->reg.a, &fuzz_case->reg.f, &fuzz_case->reg.b, &fuzz_case->reg.c,
+        &fuzz_case->reg.d, &fuzz_case->reg.e, &fuzz_case->reg.h, &fuzz_case->reg.l,
+    };
+    for (size_t i = 0; i < sizeof(reg_bytes) / sizeof(reg_bytes[0]); i++){
+        try_zero(fuzz_case, reg_bytes[i], 1);
+    }
+    try_zero(fuzz_case, (uint8_t*)&fuzz_case->reg.sp, sizeof(uint16_t));
+    if (fuzz_case->reg.ime){
+        fuzz_case->reg.ime = false;
+        if (!case_fails(fuzz_case)) fuzz_case->reg.ime = true;
+    }
+    minimize_bytes(fuzz_case, fuzz_case->rom, ROM_END);
+    minimize_bytes(fuzz_case, (uint8_t*)&fuzz_case->mem + MEMORY_STATE_START, MEMORY_STATE_END - MEMORY_STATE_START);
+}
+
+static void print_registers(const char* label, const Cpu* cpu, unsigned long cycles){
+    const Registers* r = &cpu->reg;
+    printf("  %-6s AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X PC=%04X IME=%d EI pending=%d cycles=%lu\n",
+        label, r->af, r->bc, r->de, r->hl, r->sp, r->pc, r->ime, r->ime_enable_req, cycles);
+}
+
+// Prints the non-zero bytes of data as runs, labelled with their gameboy address when known
+static void print_nonzero(const char* name, const uint8_t* data, size_t size, long address){
+    for (size_t i = 0; i < size; ){
+        if (!data[i]){
+            i++;
+            continue;
+        }
+        size_t end = i;
+        while (end < size && end - i < 16 && data[end]) end++;
+        if (address >= 0){
+            printf("  %04lX:", address + i);
+        } else {
+            printf("  %s+%zu:", name, i);
+        }
+        for (size_t j = i; j < end; j++) printf(" %02X", data[j]);
+        printf("\n");
+        i = end;
+    }
+}
+
+static void print_memory(const uint8_t* mem_bytes, const uint8_t* rom, const uint8_t* eram){
+    print_nonzero("rom", rom, ROM_END, ROM_START);
+    print_nonzero("eram", eram, EXTERNAL_RAM_SIZE, EXTERNAL_RAM_START);
+    size_t offset = MEMORY_STATE_START;
+    for (size_t i = 0; i < NUM_REGIONS; i++){
+        if (offset < regions[i].offset){
+            print_nonzero("io", mem_bytes + offset, regions[i].offset - offset, -1);
+        }
+        print_nonzero(regions[i].name, mem_bytes + regions[i].offset, regions[i].size, regions[i].address);
+        offset = regions[i].offset + regions[i].size;
+    }
+    print_nonzero("io", mem_bytes + offset, MEMORY_STATE_END - offset, -1);
+}
+
+static void print_memory_diff(const uint8_t* ref, const uint8_t* opt){
+    for (size_t offset = MEMORY_STATE_START; offset < MEMORY_STATE_END; offset++){
+        if (ref[offset] == opt[offset]) continue;
+        const char* name = "io";
+        long address = -1;
+        for (size_t i = 0; i < NUM_REGIONS; i++){
+            if (regions[i].offset <= offset && offset < regions[i].offset + regions[i].size){
+                name = regions[i].name;
+                address = regions[i].address + (offset - regions[i].offset);
+            }
+        }
+        if (address >= 0){
+            printf("  %s %04lX: reference %02X, optimized %02X\n", name, address, ref[offset], opt[offset]);
+        } else {
+            printf("  Memory+%zu: reference %02X, optimized %02X\n", offset, ref[offset], opt[offset]);
+        }
+    }
+}
+
+static void report(FuzzCase* fuzz_case, const char* kind, unsigned long index){
+    printf("mismatch in %s %lu, minimizing\n", kind, index);
+    minimize(fuzz_case);
+    case_fails(fuzz_case);
+    const Registers* r = &fuzz_case->reg;
+    printf("minimized case, %d instruction(s) from:\n", fuzz_case->num_instrs);
+    printf("  AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X PC=%04X IME=%d\n",
+        r->af, r->bc, r->de, r->hl, r->sp, r->pc, r->ime);
+    printf("non-zero memory:\n");
+    print_memory((const uint8_t*)&fuzz_case->mem, fuzz_case->rom, fuzz_case->eram);
+    printf("result:\n");
+    print_registers("ref", &ref_result.cpu, ref_result.cycles);
+    print_registers("opt", &opt_result.cpu, opt_result.cycles);
+    if (ref_result.serial.count != opt_result.serial.count ||
+        memcmp(ref_result.serial.data, opt_result.serial.data, SERIAL_LOG_SIZE) != 0){
+        printf("  serial bytes sent differ: reference %d, optimized %d\n", ref_result.serial.count, opt_result.serial.count);
+    }
+    print_memory_diff((const uint8_t*)&ref_result.mem, (const uint8_t*)&opt_result.mem);
+    for (int i = 0; i < ROM_END; i++){
+        if (ref_result.rom[i] != opt_result.rom[i]){
+            printf("  rom %04X: reference %02X, optimized %02X\n", i, ref_result.rom[i], opt_result.rom[i]);
+        }
+    }
+    for (int i = 0; i < EXTERNAL_RAM_SIZE; i++){
+        if (ref_result.eram[i] != opt_result.eram[i]){
+            printf("  eram %04X: reference %02X, optimized %02X\n", EXTERNAL_RAM_START + i, ref_result.eram[i], opt_result.eram[i]);
+        }
+    }
+}
+
+// New random registers; the 56KB of rom and memory are only refilled when fresh_memory is set,
+// since filling and copying them dominates the run time
+static void random_state(FuzzCase* fuzz_case, bool fresh_memory){
+    if (fresh_memory){
+        fill_random(fuzz_case->rom, ROM_END);
+        fill_random(fuzz_case->eram, EXTERNAL_RAM_SIZE);
+        memset(&fuzz_case->mem, 0, sizeof(Memory));
+        reset_memory(&fuzz_case->mem);
+        for (size_t i = 0; i < NUM_REGIONS; i++){
+            fill_random((uint8_t*)&fuzz_case->mem + regions[i].offset, regions[i].size);
+        }
+    }
+    fuzz_case->mem.interrupt_enable = rng();
+    fuzz_case->mem.interrupt_flag = rng() & rng();   // interrupts pending now and then
+    memset(&fuzz_case->reg, 0, sizeof(Registers));
+    fuzz_case->reg.af = rng();
+    fuzz_case->reg.bc = rng();
+    fuzz_case->reg.de = rng();
+    fuzz_case->reg.hl = rng();
+    fuzz_case->reg.sp = rng();
+    fuzz_case->reg.ime = rng() & 1;
+    fuzz_case->reg.ime_enable_req = (rng() & 7) == 0;
+}
+
+// Writes data at address in the case's rom or memory; address must be in rom or wram
+static void place(FuzzCase* fuzz_case, uint16_t address, const uint8_t* data, int size){
+    for (int i = 0; i < size; i++, address++){
+        if (address < ROM_END){
+            fuzz_case->rom[address] = data[i];
+        } else {
+            fuzz_case->mem.wram[address - WRAM_START] = data[i];
+        }
+    }
+}
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv){
+    unsigned long num_cases = 256000;
+    unsigned long num_programs = 50000;
+    int max_length = 64;
+    uint64_t seed = 1;
+    bool keep_going = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:l:s:k")) != -1){
+        switch (opt){
+            case 'n': num_cases = strtoul(optarg, NULL, 10); break;
+            case 'p': num_programs = strtoul(optarg, NULL, 10); break;
+            case 'l': max_length = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'k': keep_going = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-n cases] [-p programs] [-l length] [-s seed] [-k]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (max_length < 1) max_length = 1;
+    if (max_length > MAX_PROGRAM_LENGTH) max_length = MAX_PROGRAM_LENGTH;
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    FuzzCase* fuzz_case = malloc(sizeof(FuzzCase));
+    unsigned long mismatches = 0;
+    double start = now_seconds();
+
+    // Every opcode and CB opcode in turn, at a random pc in rom or wram
+    for (unsigned long i = 0; i < num_cases && (keep_going || !mismatches); i++){
+        random_state(fuzz_case, i % 512 == 0 || mismatches);
+        uint8_t instruction[2] = {i & 0xFF, i & 0xFF};
+        bool cb = i & 0x100;
+        if (cb) instruction[0] = 0xCB;
+        uint16_t pc = (rng() & 1) ? rng() % (ROM_END - 4) : WRAM_START + rng() % (WRAM_SIZE - 4);
+        place(fuzz_case, pc, instruction, cb ? 2 : 1);
+        fuzz_case->reg.pc = pc;
+        fuzz_case->num_instrs = 1;
+        if (case_fails(fuzz_case)){
+            mismatches++;
+            report(fuzz_case, cb ? "CB opcode case" : "opcode case", i);
+        }
+    }
+
+    // Random programs in wram; jumps leave it often enough to cover rom and the rest too
+    for (unsigned long i = 0; i < num_programs && (keep_going || !mismatches); i++){
+        random_state(fuzz_case, i % 64 == 0 || mismatches);
+        uint8_t program[MAX_PROGRAM_LENGTH * 3];
+        int length = 1 + rng() % max_length;
+        fill_random(program, length * 3);
+        uint16_t pc = WRAM_START + rng() % (WRAM_SIZE - length * 3);
+        place(fuzz_case, pc, program, length * 3);
+        fuzz_case->reg.pc = pc;
+        fuzz_case->num_instrs = length;
+        if (case_fails(fuzz_case)){
+            mismatches++;
+            report(fuzz_case, "program", i);
+        }
+    }
+
+    double seconds = now_seconds() - start;
+    printf("%lu mismatches (seed %llu, %.2fs)\n", mismatches, (unsigned long long)seed, seconds);
+    free(fuzz_case);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#include "emu_pool.h"
+#include "stdlib.h"
+#include "pthread.h"
+#include "time.h"
+#include "unistd.h"
+
+typedef struct Pool {
+    EmuJob* jobs;
+    int num_jobs;
+    int next_job;     // index of the next job to hand out
+    pthread_mutex_t lock;
+} Pool;
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run_job(EmuJob* job, Emulator* emu){
+    job->seconds = 0;
+    job->cycles_run = 0;
+    job->instrs_run = 0;
+    // a rom that doesn't fit the arena isn't run at all, but still goes to on_done
+    job->fits = setup_emulator(emu, job->rom);
+    if (!job->fits){
+        if (job->on_done) job->on_done(job, emu);
+        return;
+    }
+    set_frame_sink(&emu->gpu, FRAME_SINK_BUFFER, job->framebuffer);
+    if (job->on_start) job->on_start(job, emu);
+    
+    double start = now_seconds();
+    unsigned long last_frame = emu->gpu.frame_count;
+    while (emu->total_cycles < job->cycle_budget){
+        tick_emulator_batch(emu);
+        if (emu->gpu.frame_count != last_frame){
+            last_frame = emu->gpu.frame_count;
+            if (job->on_frame && job->on_frame(job, emu)) break;
+        }
+    }
+    job->seconds = now_seconds() - start;
+    job->cycles_run = emu->total_cycles;
+    job->instrs_run = emu->total_instrs;
+    if (job->on_done) job->on_done(job, emu);
+}
+
+static void* worker(void* arg){
+    Pool* pool = arg;
+    // Each worker reuses one instance; an Emulator is too big to keep on the stack
+    Emulator* emu = malloc(sizeof(Emulator));
+    if (!emu) return NULL;
+    for (;;){
+        pthread_mutex_lock(&pool->lock);
+        int job_indx = pool->next_job++;
+        pthread_mutex_unlock(&pool->lock);
+        if (job_indx >= pool->num_jobs) break;
+        run_job(&pool->jobs[job_indx], emu);
+    }
+    free(emu);
+    return NULL;
+}
+
+int run_emulator_pool(EmuJob* jobs, int num_jobs, int num_threads){
+    if (num_jobs <= 0) return 0;
+    if (num_threads <= 0) num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads <= 0) num_threads = 1;
+    if (num_threads > num_jobs) num_threads = num_jobs;
+    
+    Pool pool = {jobs, num_jobs, 0};
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
+    if (!threads) return -1;
+    
+    int started = 0;
+    int i;
+    for (i = 0; i < num_threads; i++){
+        if (pthread_create(&threads[i], NULL, worker, &pool) != 0) break;
+        started++;
+    }
+    for (i = 0; i < started; i++){
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&pool.lock);
+    return started > 0 ? 0 : -1;
+}
@@ -0,0 +1,38 @@
+/*
+Runs many independent emulator instances in parallel, one worker thread per core
+*/
+#ifndef EMU_POOL_H
+#define EMU_POOL_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "emulator.h"
+
+#define FRAMEBUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_HEIGHT * 2)
+
+typedef struct EmuJob EmuJob;
+struct EmuJob {
+    // Inputs
+    const char* name;
+    const uint8_t* rom;            // cartridge image; NULL uses the rom built into rom.c
+    unsigned long cycle_budget;    // machine cycles to run before giving up
+    // Called on the worker thread once the instance is set up, before it runs (hooks go here)
+    void (*on_start)(EmuJob* job, Emulator* emu);
+    // Called on the worker thread after every completed frame; return true to stop early
+    bool (*on_frame)(EmuJob* job, Emulator* emu);
+    // Called on the worker thread once the job has finished, also when it didn't fit (emu isn't set up then)
+    void (*on_done)(EmuJob* job, Emulator* emu);
+    void* user;                    // free for the caller's use
+
+    // Outputs
+    bool fits;                     // false when setup_emulator refused the rom (see EMULATOR_ARENA_SIZE): nothing was run
+    uint8_t framebuffer[FRAMEBUFFER_SIZE] __attribute__((aligned(4)));  // last rendered frame of this instance
+    unsigned long cycles_run;
+    unsigned long instrs_run;
+    double seconds;                // host wall time spent running the job
+};
+
+// Runs all jobs, with up to num_threads running at once
+// num_threads <= 0 uses one thread per online cpu core
+// Returns once every job has finished (right away for no jobs), or -1 if the workers could not be started
+int run_emulator_pool(EmuJob* jobs, int num_jobs, int num_threads);
+#endif
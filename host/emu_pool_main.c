@@ -0,0 +1,46 @@
+/*
+Runs the rom built into rom.c on several instances at once and reports their speed
+usage: emu_pool [instances] [frames] [threads]
+*/
+#include "emu_pool.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+#define CYCLES_PER_FRAME 17556   // 154 lines * 114 machine cycles
+
+static void print_result(EmuJob* job, Emulator* emu){
+    if (!job->fits){
+        printf("%s: doesn't fit in EMULATOR_ARENA_SIZE, not run\n", job->name);
+        return;
+    }
+    printf("%s: %lu cycles, %lu instrs in %.3fs (%.2fx realtime)\n", job->name, job->cycles_run, job->instrs_run,
+        job->seconds, job->seconds > 0 ? (job->cycles_run / (double) (CYCLES_PER_FRAME * 60)) / job->seconds : 0);
+}
+
+int main(int argc, char** argv){
+    int instances = argc > 1 ? atoi(argv[1]) : 4;
+    int frames = argc > 2 ? atoi(argv[2]) : 600;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    if (instances <= 0 || frames <= 0) {
+        fprintf(stderr, "usage: %s [instances] [frames] [threads]\n", argv[0]);
+        return 1;
+    }
+    
+    EmuJob* jobs = calloc(instances, sizeof(EmuJob));
+    char (*names)[32] = calloc(instances, sizeof(*names));
+    if (!jobs || !names) return 1;
+    int i;
+    for (i = 0; i < instances; i++){
+        snprintf(names[i], sizeof(names[i]), "instance %d", i);
+        jobs[i].name = names[i];
+        jobs[i].cycle_budget = (unsigned long) frames * CYCLES_PER_FRAME;
+        jobs[i].on_done = print_result;
+    }
+    if (run_emulator_pool(jobs, instances, threads) != 0){
+        fprintf(stderr, "could not start worker threads\n");
+        return 1;
+    }
+    free(names);
+    free(jobs);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "frame_output.h"
+#include "gpu.h"
+#include "stdio.h"
+#include "string.h"
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+#define PNG_ROW_SIZE (1 + DISPLAY_WIDTH * 3)   // filter byte + RGB pixels
+
+uint64_t hash_frame(const uint8_t* framebuffer){
+    uint64_t hash = FNV_OFFSET_BASIS;
+    int i;
+    for (i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT * 2; i++){
+        hash ^= framebuffer[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Expands the big-endian RGB565 pixel at indx into 8 bit r, g, b
+static void pixel_to_rgb(const uint8_t* framebuffer, int indx, uint8_t* rgb){
+    uint16_t px = (framebuffer[2 * indx] << 8) | framebuffer[2 * indx + 1];
+    uint8_t r = (px >> 11) & 0x1F;
+    uint8_t g = (px >> 5) & 0x3F;
+    uint8_t b = px & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+bool write_frame_ppm(const uint8_t* framebuffer, const char* path){
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    int i;
+    for (i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++){
+        uint8_t rgb[3];
+        pixel_to_rgb(framebuffer, i, rgb);
+        fwrite(rgb, 1, 3, f);
+    }
+    return fclose(f) == 0;
+}
+
+static uint32_t update_crc(uint32_t crc, const uint8_t* data, size_t len){
+    size_t i;
+    for (i = 0; i < len; i++){
+        crc ^= data[i];
+        int k;
+        for (k = 0; k < 8; k++){
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static void put_u32_be(uint8_t* out, uint32_t value){
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static void write_png_chunk(FILE* f, const char* type, const uint8_t* data, uint32_t len){
+    uint8_t header[8];
+    put_u32_be(header, len);
+    memcpy(&header[4], type, 4);
+    fwrite(header, 1, 8, f);
+    fwrite(data, 1, len, f);
+    uint32_t crc = update_crc(0xFFFFFFFFu, (const uint8_t*) type, 4);
+    crc = update_crc(crc, data, len) ^ 0xFFFFFFFFu;
+    uint8_t crc_bytes[4];
+    put_u32_be(crc_bytes, crc);
+    fwrite(crc_bytes, 1, 4, f);
+}
+
+// Writes a PNG whose image data uses stored (uncompressed) deflate blocks, one per row
+// This keeps the writer free of a zlib dependency; frames are only ~70KB this way
+bool write_frame_png(const uint8_t* framebuffer, const char* path){
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    // zlib header + per row (block header + row) + adler32
+    uint8_t idat[2 + DISPLAY_HEIGHT * (5 + PNG_ROW_SIZE) + 4];
+    
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fwrite(signature, 1, 8, f);
+    
+    uint8_t ihdr[13];
+    put_u32_be(&ihdr[0], DISPLAY_WIDTH);
+    put_u32_be(&ihdr[4], DISPLAY_HEIGHT);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 2;    // truecolor RGB
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // no interlace
+    write_png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    
+    uint32_t adler_a = 1, adler_b = 0;
+    int pos = 0;
+    idat[pos++] = 0x78;   // deflate, 32K window
+    idat[pos++] = 0x01;   // no preset dictionary, fastest
+    int y;
+    for (y = 0; y < DISPLAY_HEIGHT; y++){
+        idat[pos++] = (y == DISPLAY_HEIGHT - 1) ? 1 : 0;   // BFINAL on the last block, BTYPE = stored
+        idat[pos++] = PNG_ROW_SIZE & 0xFF;
+        idat[pos++] = PNG_ROW_SIZE >> 8;
+        idat[pos++] = ~PNG_ROW_SIZE & 0xFF;
+        idat[pos++] = (~PNG_ROW_SIZE >> 8) & 0xFF;
+        uint8_t* row = &idat[pos];
+        row[0] = 0;   // filter: none
+        int x;
+        for (x = 0; x < DISPLAY_WIDTH; x++){
+            pixel_to_rgb(framebuffer, y * DISPLAY_WIDTH + x, &row[1 + 3 * x]);
+        }
+        int i;
+        for (i = 0; i < PNG_ROW_SIZE; i++){
+            adler_a = (adler_a + row[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        pos += PNG_ROW_SIZE;
+    }
+    put_u32_be(&idat[pos], (adler_b << 16) | adler_a);
+    pos += 4;
+    write_png_chunk(f, "IDAT", idat, pos);
+    write_png_chunk(f, "IEND", NULL, 0);
+    return fclose(f) == 0;
+}
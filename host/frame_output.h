@@ -0,0 +1,16 @@
+/*
+Helpers for saving and fingerprinting frames rendered into a FRAME_SINK_BUFFER framebuffer
+Framebuffers hold DISPLAY_WIDTH * DISPLAY_HEIGHT big-endian RGB565 pixels
+*/
+#ifndef FRAME_OUTPUT_H
+#define FRAME_OUTPUT_H
+#include "stdint.h"
+#include "stdbool.h"
+
+// 64-bit FNV-1a hash of the whole frame; identical frames always hash the same
+uint64_t hash_frame(const uint8_t* framebuffer);
+// Write the frame as a binary PPM (P6) or an uncompressed PNG
+// Return false if the file could not be written
+bool write_frame_ppm(const uint8_t* framebuffer, const char* path);
+bool write_frame_png(const uint8_t* framebuffer, const char* path);
+#endif
@@ -0,0 +1,152 @@
+/*
+Runs the rom built into rom.c headless, printing a 64-bit hash of every frame
+and optionally saving selected frames as PPM or PNG images, and the sound as a WAV file
+usage: framedump [-r rom_id] [-f frames] [-d frame[,frame...]] [-o prefix] [-t ppm|png] [-n] [-s interval] [-p palette] [-a wav] [-m] [-b]
+    -r  run one of the test roms in rom_table.h instead (ids from emumode.h)
+    -f  number of frames to run (default 300)
+    -d  frames to save, e.g. -d 60,120,299
+    -o  output file prefix (default "frame"), files are named <prefix>_<frame>.<ppm|png>
+    -t  image type (default png)
+    -n  render to the null sink instead (no hashes or images, for timing emulation alone)
+    -s  print a per-subsystem time breakdown to stderr every interval frames
+    -p  palette preset for every layer: gray (default), green or contrast
+    -a  write the apu output to this WAV file
+    -m  print the memory layout (fixed state and arena blocks, see arena.h) to stderr
+    -b  skip the boot rom, starting at 0x0100 in the post-boot state (as START_IN_BIOS false does)
+*/
+#include "emulator.h"
+#include "frame_output.h"
+#include "wav_output.h"
+#include "rom_table.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "time.h"
+
+#define MAX_DUMP_FRAMES 64
+
+static const char* const palette_names[PALETTE_PRESET_COUNT] = {
+    [PALETTE_GRAYSCALE] = "gray",
+    [PALETTE_CLASSIC_GREEN] = "green",
+    [PALETTE_HIGH_CONTRAST] = "contrast",
+};
+
+static uint8_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT * 2] __attribute__((aligned(4)));
+static Emulator emu;
+static PerfStats perf;
+static WavOutput wav;
+
+static void write_line_stderr(void* ctx, const char* line){
+    fputs(line, stderr);
+}
+
+static int parse_frame_list(char* list, unsigned long* frames){
+    int count = 0;
+    char* tok = strtok(list, ",");
+    while (tok && count < MAX_DUMP_FRAMES){
+        frames[count++] = strtoul(tok, NULL, 10);
+        tok = strtok(NULL, ",");
+    }
+    return count;
+}
+
+int main(int argc, char** argv){
+    unsigned long num_frames = 300;
+    unsigned long dump_frames[MAX_DUMP_FRAMES];
+    int num_dump_frames = 0;
+    const char* prefix = "frame";
+    bool png = true;
+    bool null_sink = false;
+    const uint8_t* cartridge = NULL;
+    unsigned long perf_interval = 0;
+    PalettePreset palette = DEFAULT_PALETTE;
+    const char* wav_path = NULL;
+    bool print_layout = false;
+    bool skip_boot = false;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:d:o:t:ns:p:a:mb")) != -1){
+        switch (opt){
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f': num_frames = strtoul(optarg, NULL, 10); break;
+            case 'd': num_dump_frames = parse_frame_list(optarg, dump_frames); break;
+            case 'o': prefix = optarg; break;
+            case 't': png = strcmp(optarg, "ppm") != 0; break;
+            case 'n': null_sink = true; break;
+            case 's': perf_interval = strtoul(optarg, NULL, 10); break;
+            case 'p': {
+                int i;
+                for (i = 0; i < PALETTE_PRESET_COUNT; i++){
+                    if (strcmp(optarg, palette_names[i]) == 0) break;
+                }
+                if (i == PALETTE_PRESET_COUNT){
+                    fprintf(stderr, "unknown palette %s\n", optarg);
+                    return 1;
+                }
+                palette = i;
+                break;
+            }
+            case 'a': wav_path = optarg; break;
+            case 'm': print_layout = true; break;
+            case 'b': skip_boot = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-r rom_id] [-f frames] [-d frame[,frame...]] [-o prefix] [-t ppm|png] [-n] [-s interval] [-p palette] [-a wav] [-m] [-b]\n", argv[0]);
+                return 1;
+        }
+    }
+    
+    if (!setup_emulator(&emu, cartridge)){
+        fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+        report_emulator_layout(&emu, write_line_stderr, NULL);
+        return 1;
+    }
+    if (skip_boot && emu.cpu.inBios) skip_boot_rom(&emu);
+    set_palette_preset(&emu.gpu, palette);
+    set_frame_sink(&emu.gpu, null_sink ? FRAME_SINK_NULL : FRAME_SINK_BUFFER, framebuffer);
+    if (wav_path){
+        if (!open_wav(&wav, wav_path)){
+            fprintf(stderr, "could not write %s\n", wav_path);
+            return 1;
+        }
+        if (!set_apu_sink(&emu.apu, APU_SINK_CALLBACK, write_wav_samples, &wav)){
+            fprintf(stderr, "no room for the apu buffers in EMULATOR_ARENA_SIZE\n");
+            report_emulator_layout(&emu, write_line_stderr, NULL);
+            return 1;
+        }
+    }
+    if (print_layout) report_emulator_layout(&emu, write_line_stderr, NULL);
+    if (perf_interval){
+        setup_perf_stats(&perf, perf_interval, write_line_stderr, NULL);
+        set_perf_stats(&emu, &perf);
+    }
+    
+    clock_t start = clock();
+    while (emu.gpu.frame_count < num_frames){
+        unsigned long frame = emu.gpu.frame_count;
+        tick_emulator_batch(&emu);
+        if (!serial_ring_empty(&emu.serial.out)) serial_drain_uart(&emu.serial.out);   // to stdout, through the shim
+        if (null_sink || emu.gpu.frame_count == frame) continue;
+        
+        printf("frame %lu hash %016llx\n", frame, (unsigned long long) hash_frame(framebuffer));
+        int i;
+        for (i = 0; i < num_dump_frames; i++){
+            if (dump_frames[i] != frame) continue;
+            char path[256];
+            snprintf(path, sizeof(path), "%s_%lu.%s", prefix, frame, png ? "png" : "ppm");
+            bool ok = png ? write_frame_png(framebuffer, path) : write_frame_ppm(framebuffer, path);
+            if (!ok) fprintf(stderr, "could not write %s\n", path);
+        }
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (wav_path && !close_wav(&wav)) fprintf(stderr, "could not write %s\n", wav_path);
+    fprintf(stderr, "%lu frames, %lu instrs in %.3fs (%.1f fps)\n", num_frames, emu.total_instrs, seconds,
+        seconds > 0 ? num_frames / seconds : 0);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+Generates GBEmulator.cydsn/alu_tables.c from the arithmetic flag code in instruction_set.h
+Built with ALU_LOOKUP_TABLES_ON false, so every entry is what the table replaces
+usage: gen_alu_tables > ../GBEmulator.cydsn/alu_tables.c   (or make alu_tables)
+*/
+#include "cpu.h"
+#include "instruction_set.h"
+#include "alu_tables.h"
+#include "stdio.h"
+
+#if ALU_LOOKUP_TABLES_ON
+#error gen_alu_tables must be built with ALU_LOOKUP_TABLES_ON false
+#endif
+
+static void print_table(const char* declaration, const unsigned int* values, int size, int digits){
+    printf("%s = {\n", declaration);
+    for (int i = 0; i < size; i++){
+        printf("%s0x%0*X,%s", i % 16 ? " " : "    ", digits, values[i], i % 16 == 15 ? "\n" : "");
+    }
+    printf("};\n\n");
+}
+
+int main(void){
+    static unsigned int daa_values[DAA_TABLE_SIZE];
+    static unsigned int inc_values[256], dec_values[256], zero_values[256];
+    Cpu cpu = {0};
+
+    for (int flags = 0; flags < 8; flags++){
+        for (int a = 0; a < 256; a++){
+            cpu.reg.a = a;
+            cpu.reg.f = flags << 4;
+            daa(&cpu);
+            daa_values[daa_table_index(a, flags << 4)] = (cpu.reg.a << 8) | (cpu.reg.f & (FLAG_Z | FLAG_C));
+        }
+    }
+    for (int num = 0; num < 256; num++){
+        cpu.reg.f = 0;
+        uint8_t result = inc_u8(&cpu, num);
+        inc_values[result] = cpu.reg.f;
+        cpu.reg.f = 0;
+        result = dec_u8(&cpu, num);
+        dec_values[result] = cpu.reg.f;
+        zero_values[num] = num == 0 ? FLAG_Z : 0;
+    }
+
+    printf("// Generated by host/gen_alu_tables.c (make -C host alu_tables), do not edit\n");
+    printf("#include \"alu_tables.h\"\n");
+    printf("#include \"emumode.h\"\n");
+    printf("#include \"sram_code.h\"\n\n");
+    printf("#if ALU_LOOKUP_TABLES_ON\n");
+    print_table("const uint16_t daa_table[DAA_TABLE_SIZE] SRAM_TABLE(daa_table)", daa_values, DAA_TABLE_SIZE, 4);
+    print_table("const uint8_t inc_flag_table[256] SRAM_TABLE(inc_flag_table)", inc_values, 256, 2);
+    print_table("const uint8_t dec_flag_table[256] SRAM_TABLE(dec_flag_table)", dec_values, 256, 2);
+    print_table("const uint8_t zero_flag_table[256] SRAM_TABLE(zero_flag_table)", zero_values, 256, 2);
+    printf("#endif\n");
+    return 0;
+}
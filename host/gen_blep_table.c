@@ -0,0 +1,49 @@
+/*
+Generates GBEmulator.cydsn/blep_table.c: a Blackman windowed sinc impulse, cut off a bit below
+the output Nyquist frequency, sampled at BLEP_PHASES positions between two output samples
+Each phase is rounded so it sums to exactly BLEP_UNIT, so a step always ends at its full height
+usage: gen_blep_table > ../GBEmulator.cydsn/blep_table.c   (or make blep_table)
+*/
+#include "blep_table.h"
+#include "math.h"
+#include "stdio.h"
+
+#define CUTOFF 0.9      // of the output Nyquist frequency
+
+static double windowed_sinc(double x){
+    if (fabs(x) >= BLEP_TAPS / 2.0) return 0;
+    double sinc = x == 0 ? 1 : sin(M_PI * CUTOFF * x) / (M_PI * CUTOFF * x);
+    double window = 0.42 + 0.5 * cos(2 * M_PI * x / BLEP_TAPS) + 0.08 * cos(4 * M_PI * x / BLEP_TAPS);
+    return CUTOFF * sinc * window;
+}
+
+int main(void){
+    printf("// Generated by host/gen_blep_table.c (make -C host blep_table), do not edit\n");
+    printf("#include \"blep_table.h\"\n\n");
+    printf("const int16_t blep_table[BLEP_PHASES][BLEP_TAPS] = {\n");
+    for (int phase = 0; phase < BLEP_PHASES; phase++){
+        double center = BLEP_TAPS / 2 - 1 + (double) phase / BLEP_PHASES;
+        double taps[BLEP_TAPS];
+        double sum = 0;
+        for (int i = 0; i < BLEP_TAPS; i++){
+            taps[i] = windowed_sinc(i - center);
+            sum += taps[i];
+        }
+        int values[BLEP_TAPS];
+        int total = 0;
+        int largest = 0;
+        for (int i = 0; i < BLEP_TAPS; i++){
+            values[i] = (int) lround(taps[i] / sum * BLEP_UNIT);
+            total += values[i];
+            if (values[i] > values[largest]) largest = i;
+        }
+        values[largest] += BLEP_UNIT - total;
+        printf("    {");
+        for (int i = 0; i < BLEP_TAPS; i++){
+            printf("%s%d", i ? ", " : "", values[i]);
+        }
+        printf("},\n");
+    }
+    printf("};\n");
+    return 0;
+}
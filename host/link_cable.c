@@ -0,0 +1,140 @@
+#include "link_cable.h"
+#include "string.h"
+#include "unistd.h"
+#include "sys/socket.h"
+#include "sys/un.h"
+
+static void init_link(LinkCable* link, Emulator* a, Emulator* b, int fd){
+    memset(link, 0, sizeof(LinkCable));
+    link->sides[0] = a;
+    link->sides[1] = b;
+    link->fd = fd;
+    link->time = a->total_cycles;
+    link->quantum = LINK_MAX_QUANTUM;
+    a->serial.linked = true;
+    if (b) b->serial.linked = true;
+}
+
+void setup_link_in_process(LinkCable* link, Emulator* a, Emulator* b){
+    init_link(link, a, b, -1);
+}
+
+void setup_link_socket(LinkCable* link, Emulator* emu, int fd){
+    init_link(link, emu, NULL, fd);
+}
+
+static int unix_socket(const char* path, struct sockaddr_un* addr){
+    if (strlen(path) >= sizeof(addr->sun_path)) return -1;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+int link_listen(const char* path){
+    struct sockaddr_un addr;
+    int listen_fd = unix_socket(path, &addr);
+    if (listen_fd < 0) return -1;
+    unlink(path);
+    int fd = -1;
+    if (bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) == 0 && listen(listen_fd, 1) == 0){
+        fd = accept(listen_fd, NULL, NULL);
+    }
+    close(listen_fd);
+    unlink(path);
+    return fd;
+}
+
+int link_connect(const char* path){
+    struct sockaddr_un addr;
+    int fd = unix_socket(path, &addr);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool write_all(int fd, const void* data, size_t len){
+    const uint8_t* bytes = data;
+    while (len > 0){
+        ssize_t n = write(fd, bytes, len);
+        if (n <= 0) return false;
+        bytes += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t len){
+    uint8_t* bytes = data;
+    while (len > 0){
+        ssize_t n = read(fd, bytes, len);
+        if (n <= 0) return false;
+        bytes += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void run_side(Emulator* emu, unsigned long until, void (*on_frame)(void* ctx, int side), void* ctx, int side){
+    while (emu->total_cycles < until){
+        unsigned long frame = emu->gpu.frame_count;
+        tick_emulator_batch(emu);
+        if (on_frame && emu->gpu.frame_count != frame) on_frame(ctx, side);
+    }
+}
+
+// Swaps the two states and resolves both sides; returns false if the other process hung up
+static bool sync_sides(LinkCable* link, SerialLinkState states[2]){
+    states[0] = serial_link_state(&link->sides[0]->serial);
+    if (link->fd < 0){
+        states[1] = serial_link_state(&link->sides[1]->serial);
+    } else {
+        uint8_t out[2] = {states[0].flags, states[0].sb};
+        uint8_t in[2];
+        if (!write_all(link->fd, out, 2) || !read_all(link->fd, in, 2)) return false;
+        states[1].flags = in[0];
+        states[1].sb = in[1];
+    }
+    if (states[0].flags & SERIAL_LINK_MASTER_WAITING) link->transfers++;
+    if ((states[0].flags & SERIAL_LINK_SLAVE_READY) && (states[1].flags & SERIAL_LINK_MASTER_WAITING)) link->transfers++;
+    resolve_serial_link(&link->sides[0]->serial, states[0], states[1]);
+    if (link->fd < 0) resolve_serial_link(&link->sides[1]->serial, states[1], states[0]);
+    link->syncs++;
+    return true;
+}
+
+bool run_link(LinkCable* link, unsigned long machine_cycles, void (*on_frame)(void* ctx, int side), void* ctx){
+    unsigned long end = link->time + machine_cycles;
+    while (link->time < end){
+        link->time += link->quantum;
+        run_side(link->sides[0], link->time, on_frame, ctx, 0);
+        if (link->fd < 0) run_side(link->sides[1], link->time, on_frame, ctx, 1);
+
+        SerialLinkState states[2];
+        if (!sync_sides(link, states)) return false;
+        bool busy = (states[0].flags | states[1].flags) & SERIAL_LINK_BUSY;
+        if (busy){
+            link->quantum = LINK_MIN_QUANTUM;
+        } else if (link->quantum < LINK_MAX_QUANTUM){
+            link->quantum = link->quantum * 2 < LINK_MAX_QUANTUM ? link->quantum * 2 : LINK_MAX_QUANTUM;
+        }
+    }
+    return true;
+}
+
+void close_link(LinkCable* link){
+    int side;
+    for (side = 0; side < 2; side++){
+        Serial* serial = link->sides[side] ? &link->sides[side]->serial : NULL;
+        if (!serial) continue;
+        // a byte still waiting for the other side gets what an unplugged cable gives
+        SerialLinkState unplugged = {0, 0xFF};
+        resolve_serial_link(serial, serial_link_state(serial), unplugged);
+        serial->linked = false;
+    }
+    if (link->fd >= 0) close(link->fd);
+    link->fd = -1;
+}
@@ -0,0 +1,39 @@
+/*
+Link cable between two emulator instances, either both in this process or one on each end of a socket
+Instead of running the two sides in lockstep, each side runs a quantum of machine cycles on its own and
+the sides only sync at quantum boundaries, where finished serial transfers are resolved (serial.h).
+The quantum shrinks to one serial transfer time while either side uses the serial port and doubles
+back up to a frame while both are idle, so a link costs next to nothing until the game talks over it.
+Both sides pick the next quantum from the same pair of states, so they always agree on it
+*/
+#ifndef LINK_CABLE_H
+#define LINK_CABLE_H
+#include "emulator.h"
+#include "stdbool.h"
+
+#define LINK_MIN_QUANTUM SERIAL_TRANSFER_CYCLES     // machine cycles
+#define LINK_MAX_QUANTUM 17556                      // one frame
+
+typedef struct LinkCable {
+    Emulator* sides[2];        // in process: both sides; over a socket: sides[0] only
+    int fd;                    // socket to the other process, -1 in process
+    unsigned long time;        // machine cycles both sides have run up to
+    unsigned long quantum;
+    unsigned long syncs;
+    unsigned long transfers;   // transfers resolved on sides[0]
+} LinkCable;
+
+// Connects a and b, which must already be set up
+void setup_link_in_process(LinkCable* link, Emulator* a, Emulator* b);
+// Connects emu to the emulator in the process at the other end of fd (see link_listen and link_connect)
+void setup_link_socket(LinkCable* link, Emulator* emu, int fd);
+// Unix domain sockets for two processes: one listens on path, the other connects to it
+// Both return the connected socket, or -1 on failure
+int link_listen(const char* path);
+int link_connect(const char* path);
+// Runs the linked sides for at least machine_cycles more; on_frame, if not NULL, is called with each side
+// that completes a frame. Returns false if the other process hung up
+bool run_link(LinkCable* link, unsigned long machine_cycles, void (*on_frame)(void* ctx, int side), void* ctx);
+// Disconnects: both sides go back to unlinked transfers, and the socket is closed
+void close_link(LinkCable* link);
+#endif
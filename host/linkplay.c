@@ -0,0 +1,95 @@
+/*
+Runs two instances of a rom joined by a link cable (link_cable.h), headless
+Both can run in this process, or each in its own process over a unix socket:
+    linkplay -l /tmp/gb.sock &    (first player, waits for the second)
+    linkplay -c /tmp/gb.sock      (second player)
+usage: linkplay [-r rom_id] [-f frames] [-l path | -c path] [-o prefix]
+    -r  run one of the test roms in rom_table.h instead (ids from emumode.h)
+    -f  number of frames to run (default 600)
+    -l  listen on a unix socket for the other process
+    -c  connect to the process listening on path
+    -o  save each side's last frame as <prefix>_<side>.png
+*/
+#include "link_cable.h"
+#include "frame_output.h"
+#include "rom_table.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "time.h"
+
+static uint8_t framebuffers[2][DISPLAY_WIDTH * DISPLAY_HEIGHT * 2] __attribute__((aligned(4)));
+static Emulator emus[2];
+
+int main(int argc, char** argv){
+    unsigned long num_frames = 600;
+    const uint8_t* cartridge = NULL;
+    const char* listen_path = NULL;
+    const char* connect_path = NULL;
+    const char* prefix = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:l:c:o:")) != -1){
+        switch (opt){
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f': num_frames = strtoul(optarg, NULL, 10); break;
+            case 'l': listen_path = optarg; break;
+            case 'c': connect_path = optarg; break;
+            case 'o': prefix = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-r rom_id] [-f frames] [-l path | -c path] [-o prefix]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    bool in_process = !listen_path && !connect_path;
+    int num_sides = in_process ? 2 : 1;
+    int side;
+    for (side = 0; side < num_sides; side++){
+        if (!setup_emulator(&emus[side], cartridge)){
+            fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+            return 1;
+        }
+        set_frame_sink(&emus[side].gpu, FRAME_SINK_BUFFER, framebuffers[side]);
+    }
+    LinkCable link;
+    if (in_process){
+        setup_link_in_process(&link, &emus[0], &emus[1]);
+    } else {
+        int fd = listen_path ? link_listen(listen_path) : link_connect(connect_path);
+        if (fd < 0){
+            fprintf(stderr, "could not open the link socket %s\n", listen_path ? listen_path : connect_path);
+            return 1;
+        }
+        setup_link_socket(&link, &emus[0], fd);
+    }
+
+    clock_t start = clock();
+    bool connected = true;
+    while (connected && emus[0].gpu.frame_count < num_frames){
+        connected = run_link(&link, LINK_MAX_QUANTUM, NULL, NULL);
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    close_link(&link);
+    if (!connected) fprintf(stderr, "the other side hung up\n");
+
+    for (side = 0; side < num_sides; side++){
+        printf("side %d frame %lu hash %016llx\n", side, emus[side].gpu.frame_count,
+            (unsigned long long) hash_frame(framebuffers[side]));
+        if (prefix){
+            char path[256];
+            snprintf(path, sizeof(path), "%s_%d.png", prefix, side);
+            if (!write_frame_png(framebuffers[side], path)) fprintf(stderr, "could not write %s\n", path);
+        }
+    }
+    fprintf(stderr, "%lu frames per side, %lu syncs, %lu transfers in %.3fs (%.1f fps per side)\n",
+        emus[0].gpu.frame_count, link.syncs, link.transfers, seconds, seconds > 0 ? emus[0].gpu.frame_count / seconds : 0);
+    return connected ? 0 : 1;
+}
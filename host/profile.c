@@ -0,0 +1,61 @@
+/*
+Runs a rom headless with the per-opcode profiler attached and writes the profile as CSV
+usage: profile [-r rom_id] [-f frames] [-o out.csv]
+    -r  run one of the test roms in rom_table.h instead of the rom built into rom.c
+    -f  number of frames to run (default 600)
+    -o  output file (default stdout)
+*/
+#include "emulator.h"
+#include "rom_table.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "unistd.h"
+
+static Emulator emu;
+static Profiler profiler;
+
+static void write_line_file(void* ctx, const char* line){
+    fputs(line, ctx);
+}
+
+int main(int argc, char** argv){
+    const uint8_t* cartridge = NULL;
+    unsigned long num_frames = 600;
+    const char* out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:o:")) != -1){
+        switch (opt){
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f': num_frames = strtoul(optarg, NULL, 10); break;
+            case 'o': out_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-r rom_id] [-f frames] [-o out.csv]\n", argv[0]);
+                return 1;
+        }
+    }
+    
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out){
+        perror(out_path);
+        return 1;
+    }
+    if (!setup_emulator(&emu, cartridge)){
+        fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+        return 1;
+    }
+    set_frame_sink(&emu.gpu, FRAME_SINK_NULL, NULL);
+    reset_profiler(&profiler);
+    emu.cpu.profiler = &profiler;
+    while (emu.gpu.frame_count < num_frames){
+        tick_emulator_batch(&emu);
+    }
+    profiler_report(&profiler, write_line_file, out);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include "rom_table.h"
+#include "emumode.h"
+#include "stddef.h"
+
+extern const uint8_t rom_1[], rom_2[], rom_3[], rom_4[], rom_5[], rom_6[];
+extern const uint8_t rom_7[], rom_8[], rom_9[], rom_10[], rom_11[], rom_12[];
+
+const TestRom test_roms[] = {
+    {TEST_ROM_CPU_INSTRS_1_SPECIAL, "cpu_instrs 01-special", rom_1, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_2_INTERRUPTS, "cpu_instrs 02-interrupts", rom_2, ROM_CHECK_SERIAL, 0, true},
+    {TEST_ROM_CPU_INSTRS_3_OP_SP_HL, "cpu_instrs 03-op sp,hl", rom_3, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_4_OP_R_IMM, "cpu_instrs 04-op r,imm", rom_4, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_5_OP_RP, "cpu_instrs 05-op rp", rom_5, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_6_LD_R_R, "cpu_instrs 06-ld r,r", rom_6, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_7_JR_CALL_RET_RST, "cpu_instrs 07-jr,jp,call,ret,rst", rom_7, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_8_MISC_INSTRS, "cpu_instrs 08-misc instrs", rom_8, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_9_OP_R_R, "cpu_instrs 09-op r,r", rom_9, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_10_BIT_OPS, "cpu_instrs 10-bit ops", rom_10, ROM_CHECK_SERIAL, 0, false},
+    {TEST_ROM_CPU_INSTRS_11_OP_A_MHL, "cpu_instrs 11-op a,(hl)", rom_11, ROM_CHECK_SERIAL, 0, false},
+    // Hash of the reference dmg-acid2 face as rendered with the default palette
+    {TEST_DMG_ACID_2, "dmg-acid2", rom_12, ROM_CHECK_FRAME_HASH, 0x0377EFB2B2CCB147ULL, false},
+};
+const int num_test_roms = sizeof(test_roms) / sizeof(test_roms[0]);
+
+const uint8_t* find_test_rom(int id){
+    int i;
+    for (i = 0; i < num_test_roms; i++){
+        if (test_roms[i].id == id) return test_roms[i].rom;
+    }
+    return NULL;
+}
@@ -0,0 +1,29 @@
+/*
+Every test rom from rom.c, linked into the host build side by side
+Each one is rom.c compiled again with ROM set to its id (see the Makefile)
+*/
+#ifndef ROM_TABLE_H
+#define ROM_TABLE_H
+#include "stdint.h"
+#include "stdbool.h"
+
+typedef enum RomCheck {
+    ROM_CHECK_SERIAL,      // test prints "Passed" or "Failed" over serial
+    ROM_CHECK_FRAME_HASH   // test is visual; passes once a frame matches pass_frame_hash
+} RomCheck;
+
+typedef struct TestRom {
+    int id;                   // rom id from emumode.h
+    const char* name;
+    const uint8_t* rom;
+    RomCheck check;
+    uint64_t pass_frame_hash; // ROM_CHECK_FRAME_HASH only (see frame_output.h)
+    bool known_failure;       // currently expected to fail; doesn't fail the run
+} TestRom;
+
+extern const TestRom test_roms[];
+extern const int num_test_roms;
+
+// The rom of the test rom with this id, NULL when there is none
+const uint8_t* find_test_rom(int id);
+#endif
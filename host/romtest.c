@@ -0,0 +1,147 @@
+/*
+Boots every test rom in rom_table.h headless, in parallel, and checks its verdict
+Serial test roms pass once they print "Passed" and fail once they print "Failed";
+visual test roms pass once a frame matches their known good frame hash
+Also reports how many cycles each rom took to reach its verdict, so it doubles as a timing benchmark
+usage: romtest [-b cycle_budget] [-j threads] [-v]
+    -b  machine cycles each rom may run before it times out (default 60 emulated seconds)
+    -j  worker threads (default one per core)
+    -v  print the serial output of every rom
+Exits non-zero if a rom that isn't a known failure doesn't pass within the budget
+*/
+#include "emu_pool.h"
+#include "rom_table.h"
+#include "frame_output.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+
+#define MACHINE_CYCLES_PER_SECOND 1048576
+#define DEFAULT_CYCLE_BUDGET (60UL * MACHINE_CYCLES_PER_SECOND)
+#define SERIAL_CAPTURE_SIZE 4096
+
+typedef enum Verdict {
+    VERDICT_TIMEOUT,
+    VERDICT_PASSED,
+    VERDICT_FAILED,
+    VERDICT_NO_FIT      // setup_emulator refused it, so it never ran
+} Verdict;
+
+typedef struct RomRun {
+    const TestRom* test;
+    Emulator* emu;
+    char serial[SERIAL_CAPTURE_SIZE];
+    int serial_len;
+    Verdict verdict;
+    unsigned long cycles_to_verdict;
+    uint64_t last_frame_hash;
+} RomRun;
+
+static const char* verdict_names[] = {"TIMEOUT", "Passed", "Failed", "NOFIT"};
+
+static void set_verdict(RomRun* run, Verdict verdict){
+    if (run->verdict != VERDICT_TIMEOUT) return;
+    run->verdict = verdict;
+    run->cycles_to_verdict = run->emu->total_cycles;
+}
+
+static void capture_serial(void* ctx, uint8_t data){
+    RomRun* run = ctx;
+    if (run->serial_len >= SERIAL_CAPTURE_SIZE - 1) return;
+    run->serial[run->serial_len++] = data;
+    run->serial[run->serial_len] = '\0';
+    if (strstr(run->serial, "Passed")){
+        set_verdict(run, VERDICT_PASSED);
+    } else if (strstr(run->serial, "Failed")){
+        set_verdict(run, VERDICT_FAILED);
+    }
+}
+
+static void on_start(EmuJob* job, Emulator* emu){
+    RomRun* run = job->user;
+    run->emu = emu;
+    emu->mem.serial_hook = capture_serial;
+    emu->mem.serial_hook_ctx = run;
+}
+
+static bool on_frame(EmuJob* job, Emulator* emu){
+    RomRun* run = job->user;
+    if (run->test->check == ROM_CHECK_FRAME_HASH){
+        run->last_frame_hash = hash_frame(job->framebuffer);
+        if (run->last_frame_hash == run->test->pass_frame_hash){
+            set_verdict(run, VERDICT_PASSED);
+        }
+    }
+    return run->verdict != VERDICT_TIMEOUT;
+}
+
+int main(int argc, char** argv){
+    unsigned long cycle_budget = DEFAULT_CYCLE_BUDGET;
+    int threads = 0;
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:j:v")) != -1){
+        switch (opt){
+            case 'b': cycle_budget = strtoul(optarg, NULL, 10); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'v': verbose = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-b cycle_budget] [-j threads] [-v]\n", argv[0]);
+                return 2;
+        }
+    }
+    
+    EmuJob* jobs = calloc(num_test_roms, sizeof(EmuJob));
+    RomRun* runs = calloc(num_test_roms, sizeof(RomRun));
+    if (!jobs || !runs) return 2;
+    int i;
+    for (i = 0; i < num_test_roms; i++){
+        runs[i].test = &test_roms[i];
+        jobs[i].name = test_roms[i].name;
+        jobs[i].rom = test_roms[i].rom;
+        jobs[i].cycle_budget = cycle_budget;
+        jobs[i].on_start = on_start;
+        jobs[i].on_frame = on_frame;
+        jobs[i].user = &runs[i];
+    }
+    if (run_emulator_pool(jobs, num_test_roms, threads) != 0){
+        fprintf(stderr, "could not start worker threads\n");
+        return 2;
+    }
+    
+    int unexpected = 0;
+    unsigned long total_cycles = 0;
+    double total_seconds = 0;
+    printf("%-34s %-8s %14s %10s\n", "ROM", "RESULT", "CYCLES", "HOST TIME");
+    for (i = 0; i < num_test_roms; i++){
+        RomRun* run = &runs[i];
+        if (!jobs[i].fits) run->verdict = VERDICT_NO_FIT;
+        bool passed = run->verdict == VERDICT_PASSED;
+        const char* note = "";
+        if (!passed && run->test->known_failure){
+            note = " (known failure)";
+        } else if (!passed){
+            note = " <-- REGRESSION";
+            unexpected++;
+        } else if (run->test->known_failure){
+            note = " (known failure now passes, update rom_table.c)";
+        }
+        printf("%-34s %-8s %14lu %9.3fs%s\n", run->test->name, verdict_names[run->verdict],
+            passed ? run->cycles_to_verdict : jobs[i].cycles_run, jobs[i].seconds, note);
+        if (run->test->check == ROM_CHECK_FRAME_HASH && !passed){
+            printf("    last frame hash %016llx\n", (unsigned long long) run->last_frame_hash);
+        }
+        if (verbose && run->serial_len){
+            printf("%s\n", run->serial);
+        }
+        total_cycles += jobs[i].cycles_run;
+        total_seconds += jobs[i].seconds;
+    }
+    printf("\n%lu machine cycles emulated in %.3fs of worker time (%.1f emulated MHz)\n", total_cycles, total_seconds,
+        total_seconds > 0 ? total_cycles * 4.0 / total_seconds / 1e6 : 0);
+    printf("%d unexpected result%s\n", unexpected, unexpected == 1 ? "" : "s");
+    free(runs);
+    free(jobs);
+    return unexpected ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+Measures each TFT output scale (OUTPUT_SCALE_* in gpu.h): the host time renderLine takes to write
+the scaled lines and the SPI time the scaled frame takes at TFT_SPI_BITRATE, which is what bounds
+the frame rate on the PSoC. Also checks every scaled frame against the 1x one, pixel by pixel
+usage: scalebench [-r rom_id] [-f frames]
+    -r  run one of the test roms in rom_table.h instead of the rom built into rom.c
+    -f  number of frames to run per scale (default 600)
+*/
+#include "emulator.h"
+#include "rom_table.h"
+#include "tft.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "time.h"
+
+#define MAX_FRAMEBUFFER_SIZE (SCALED(DISPLAY_WIDTH, OUTPUT_SCALE_2X) * 2 * DISPLAY_HEIGHT)
+
+static const uint8_t scales[] = {OUTPUT_SCALE_1X, OUTPUT_SCALE_1_5X, OUTPUT_SCALE_2X};
+static const char* const scale_names[] = {"1x", "1.5x", "2x"};
+
+static uint8_t framebuffer[MAX_FRAMEBUFFER_SIZE] __attribute__((aligned(4)));
+static uint8_t framebuffer_1x[MAX_FRAMEBUFFER_SIZE];
+static Emulator emu;
+static PerfStats perf;
+
+static uint16_t pixel_at(const uint8_t* fb, uint8_t scale, int x, int y){
+    const uint8_t* px = &fb[(y * SCALED(DISPLAY_WIDTH, scale) + x) * 2];
+    return (px[0] << 8) | px[1];
+}
+
+// Number of pixels of the last scaled frame that differ from the 1x frame scaled up nearest neighbour
+static int count_mismatches(uint8_t scale){
+    int mismatches = 0;
+    int x, y;
+    for (y = 0; y < DISPLAY_HEIGHT; y++){
+        for (x = 0; x < SCALED(DISPLAY_WIDTH, scale); x++){
+            if (pixel_at(framebuffer, scale, x, y) != pixel_at(framebuffer_1x, OUTPUT_SCALE_1X, x * 2 / scale, y)) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv){
+    const uint8_t* cartridge = NULL;
+    unsigned long num_frames = 600;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:")) != -1){
+        switch (opt){
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f': num_frames = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-r rom_id] [-f frames]\n", argv[0]);
+                return 1;
+        }
+    }
+    
+    printf("%-6s %-9s %-6s %12s %12s %12s %12s %10s\n", "scale", "size", "fits", "render us/f", "host fps",
+        "spi bytes/f", "spi ms/f", "mismatches");
+    int failures = 0;
+    int s;
+    for (s = 0; s < (int) sizeof(scales); s++){
+        uint8_t scale = scales[s];
+        if (!setup_emulator(&emu, cartridge)){
+            fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+            return 1;
+        }
+        set_frame_sink(&emu.gpu, FRAME_SINK_BUFFER, framebuffer);
+        set_output_scale(&emu.gpu, scale);
+        // one report window covering the whole run, read directly instead of reported
+        setup_perf_stats(&perf, num_frames + 1, NULL, NULL);
+        set_perf_stats(&emu, &perf);
+        
+        clock_t start = clock();
+        while (emu.gpu.frame_count < num_frames){
+            tick_emulator_batch(&emu);
+        }
+        double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+        
+        int mismatches = 0;
+        if (scale == OUTPUT_SCALE_1X){
+            memcpy(framebuffer_1x, framebuffer, sizeof(framebuffer));
+        } else {
+            mismatches = count_mismatches(scale);
+            if (mismatches) failures++;
+        }
+        
+        // every line goes out scaled_line_sends times, by the DMA
+        unsigned long spi_bytes = 0;
+        int ly;
+        for (ly = 0; ly < DISPLAY_HEIGHT; ly++){
+            spi_bytes += scaled_line_sends(scale, ly) * SCALED(DISPLAY_WIDTH, scale) * 2;
+        }
+        int width = SCALED(DISPLAY_WIDTH, scale);
+        int height = SCALED(DISPLAY_HEIGHT, scale);
+        char size[16];
+        snprintf(size, sizeof(size), "%dx%d", width, height);
+        // host perf ticks are nanoseconds (perfstats.c)
+        printf("%-6s %-9s %-6s %12.1f %12.1f %12lu %12.2f %10d\n", scale_names[s], size,
+            width <= TFT_WIDTH && height <= TFT_HEIGHT ? "yes" : "no",
+            perf.ticks[PERF_RENDER] / 1000.0 / num_frames, seconds > 0 ? num_frames / seconds : 0,
+            spi_bytes, spi_bytes * 8 * 1000.0 / TFT_SPI_BITRATE, mismatches);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+/*
+Host (PC) stand-in for the PSoC Creator generated project.h
+Only declares the parts of the generated component APIs that the emulator core uses,
+so the core can be compiled and run headless by the tools in host/
+*/
+#ifndef PROJECT_H
+#define PROJECT_H
+#include "stdint.h"
+#include "stdbool.h"
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int16_t int16;
+typedef char char8;
+
+#define CY_ISR(name) void name(void)
+typedef void (*cyisraddress)(void);
+#define CyGlobalIntEnable
+
+void CyDelay(uint32 milliseconds);
+
+// UART_1 (written to stdout on host)
+void UART_1_Start(void);
+void UART_1_PutChar(uint8 txDataByte);
+void UART_1_PutString(const char8 string[]);
+#define UART_1_TX_STS_FIFO_NOT_FULL 0x08u
+uint8 UART_1_ReadTxStatus(void);
+void UART_1_WriteTxData(uint8 txDataByte);
+// The TX interrupt fires as soon as it is unmasked, as the host FIFO is never full
+void UART_1_SetTxInterruptMode(uint8 intSrc);
+void isr_uart_tx_StartEx(cyisraddress address);
+
+// Joystick ADCs and buttons (report a centered joystick and no buttons pressed)
+int16 ADC_JOY_X_GetResult16(void);
+int16 ADC_JOY_Y_GetResult16(void);
+uint8 Button_Status_Read(void);
+
+// TFT data/command line
+void DC_Write(uint8 value);
+#endif
@@ -0,0 +1,73 @@
+/*
+Host implementations of the PSoC peripherals used by the emulator core
+The SPI/DMA path to the TFT is a no-op that is always ready, so rendering never waits
+*/
+#include <project.h>
+#include "tft.h"
+#include "stdio.h"
+
+#define JOY_CENTERED 2048
+#define BUTTONS_RELEASED 0x0F   // buttons are active low
+
+void CyDelay(uint32 milliseconds){
+}
+
+void UART_1_Start(void){
+}
+void UART_1_PutChar(uint8 txDataByte){
+    putchar(txDataByte);
+}
+void UART_1_PutString(const char8 string[]){
+    fputs(string, stdout);
+}
+uint8 UART_1_ReadTxStatus(void){
+    return UART_1_TX_STS_FIFO_NOT_FULL;
+}
+void UART_1_WriteTxData(uint8 txDataByte){
+    putchar(txDataByte);
+}
+static cyisraddress uart_tx_isr;
+void UART_1_SetTxInterruptMode(uint8 intSrc){
+    if ((intSrc & UART_1_TX_STS_FIFO_NOT_FULL) && uart_tx_isr) uart_tx_isr();
+}
+void isr_uart_tx_StartEx(cyisraddress address){
+    uart_tx_isr = address;
+}
+
+int16 ADC_JOY_X_GetResult16(void){
+    return JOY_CENTERED;
+}
+int16 ADC_JOY_Y_GetResult16(void){
+    return JOY_CENTERED;
+}
+uint8 Button_Status_Read(void){
+    return BUTTONS_RELEASED;
+}
+
+void DC_Write(uint8 value){
+}
+
+// tft.h
+void setDClow(void){
+}
+void setDChigh(void){
+}
+void write8_a0(uint8 data){
+}
+void write8_a1(uint8 data){
+}
+void writeM8_a1(uint8 *pData, int N){
+}
+void tftStart(void){
+}
+void setupDma(uint8_t* dma_buff, uint32_t burstLength){
+}
+bool isDmaReady(void){
+    return true;
+}
+void tftSetWindow(uint16 SC, uint16 EC, uint16 SP, uint16 EP){
+}
+void tftClear(void){
+}
+void startDmaTransfer(uint8_t sends){
+}
@@ -0,0 +1,184 @@
+/*
+Picks the functions worth running from SRAM (SRAM_HOT_CODE_ON, see sram_code.h) and shows what a build
+placed there. Reads a gprof flat profile (gprof -b -p) and a symbol listing (readelf -sW), ranks the
+functions by self time and marks the ones that fit the budget, hottest first
+The sizes are the listing's: use arm-none-eabi-readelf -sW on the PSoC build's elf for the real Thumb-2 sizes.
+Functions at PSoC 5LP SRAM addresses in that listing are already placed in SRAM, and are summed up
+as the budget consumed, next to the variables and tables that share the SRAM
+usage: sramreport -p profile.txt -s symbols.txt [-b budget_bytes] [-n count]
+    -b  bytes of SRAM to spend on code (default 16384)
+    -n  number of functions to list (default 30)
+make sramreport does the whole thing on the host build (see Makefile)
+*/
+#include "stdio.h"
+#include "stdbool.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+
+#define MAX_FUNCTIONS 4096
+#define MAX_NAME 128
+// PSoC 5LP SRAM: 32KB below 0x20000000 on the code bus and 32KB above it on the system bus
+#define SRAM_START 0x1FFF8000UL
+#define SRAM_END 0x20008000UL
+
+typedef struct Function {
+    char name[MAX_NAME];
+    double self_seconds;
+    double percent;
+    unsigned long calls;
+    unsigned long size;      // 0 when the listing doesn't have it
+} Function;
+
+static Function functions[MAX_FUNCTIONS];
+static int num_functions;
+
+// gcc clones like fetch_ram.constprop.0 are counted under the function they came from
+static void base_name(char* dst, const char* src){
+    size_t len = strcspn(src, ".");
+    if (len >= MAX_NAME) len = MAX_NAME - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static Function* find_function(const char* name){
+    char base[MAX_NAME];
+    base_name(base, name);
+    for (int i = 0; i < num_functions; i++){
+        if (!strcmp(functions[i].name, base)) return &functions[i];
+    }
+    if (num_functions == MAX_FUNCTIONS) return NULL;
+    Function* f = &functions[num_functions++];
+    memset(f, 0, sizeof(*f));
+    strcpy(f->name, base);
+    return f;
+}
+
+// Lines of the flat profile look like
+//   22.73      0.05     0.05  1903748     0.00     0.00  run_cycles
+// where the calls and per call columns are missing for functions built without -pg
+static int read_profile(const char* path){
+    FILE* in = fopen(path, "r");
+    if (!in){
+        perror(path);
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), in)){
+        char* tokens[8];
+        int count = 0;
+        for (char* token = strtok(line, " \t\n"); token && count < 8; token = strtok(NULL, " \t\n")){
+            tokens[count++] = token;
+        }
+        if ((count != 4 && count != 7) || !strchr(tokens[0], '.') || !strchr(tokens[2], '.')) continue;
+        char* end;
+        double percent = strtod(tokens[0], &end);
+        if (*end) continue;
+        Function* f = find_function(tokens[count - 1]);
+        if (!f) break;
+        f->percent += percent;
+        f->self_seconds += atof(tokens[2]);
+        if (count == 7) f->calls += strtoul(tokens[3], NULL, 10);
+    }
+    fclose(in);
+    return 0;
+}
+
+// Lines of readelf -sW look like "  1234: 0000000000001a40   774 FUNC    GLOBAL DEFAULT   16 run_cycles"
+// Takes the sizes of the profiled functions and sums up what sits in SRAM. SRAM code lands in .data,
+// so only the symbol type (not nm's section letter) tells it apart from variables
+static int read_symbols(const char* path){
+    FILE* in = fopen(path, "r");
+    if (!in){
+        perror(path);
+        return -1;
+    }
+    unsigned long sram_code = 0, sram_data = 0;
+    int placed = 0;
+    char line[512];
+    printf("Code placed in SRAM:\n");
+    while (fgets(line, sizeof(line), in)){
+        unsigned long address;
+        char size_text[32], type[16], bind[16], visibility[16], index[16];
+        char name[MAX_NAME];
+        if (sscanf(line, " %*[0-9]: %lx %31s %15s %15s %15s %15s %127s", &address, size_text, type, bind, visibility, index, name) != 7) continue;
+        unsigned long size = strtoul(size_text, NULL, 0);
+        bool is_code = !strcmp(type, "FUNC");
+        if (is_code){
+            Function* f = NULL;
+            char base[MAX_NAME];
+            base_name(base, name);
+            for (int i = 0; i < num_functions && !f; i++){
+                if (!strcmp(functions[i].name, base)) f = &functions[i];
+            }
+            // the boot phase copy of a static function shares its name; keep the bigger one
+            if (f && size > f->size) f->size = size;
+        }
+        if (address < SRAM_START || address >= SRAM_END) continue;
+        if (is_code){
+            printf("  %-32s %6lu bytes\n", name, size);
+            sram_code += size;
+            placed++;
+        } else if (!strcmp(type, "OBJECT")){
+            sram_data += size;
+        }
+    }
+    fclose(in);
+    if (!placed) printf("  nothing (a host build, or SRAM_HOT_CODE_ON is off)\n");
+    else printf("  %lu bytes of code\n", sram_code);
+    if (placed || sram_data) printf("%lu bytes of variables and SRAM tables, %lu of %lu bytes of SRAM used\n",
+                                    sram_data, sram_code + sram_data, SRAM_END - SRAM_START);
+    printf("\n");
+    return 0;
+}
+
+static int by_self_time(const void* a, const void* b){
+    const Function* fa = a;
+    const Function* fb = b;
+    if (fa->self_seconds != fb->self_seconds) return fa->self_seconds < fb->self_seconds ? 1 : -1;
+    return fa->calls < fb->calls ? 1 : fa->calls > fb->calls ? -1 : 0;
+}
+
+int main(int argc, char** argv){
+    const char* profile_path = NULL;
+    const char* symbols_path = NULL;
+    unsigned long budget = 16384;
+    int list_count = 30;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:b:n:")) != -1){
+        switch (opt){
+            case 'p': profile_path = optarg; break;
+            case 's': symbols_path = optarg; break;
+            case 'b': budget = strtoul(optarg, NULL, 0); break;
+            case 'n': list_count = atoi(optarg); break;
+            default: profile_path = NULL; break;
+        }
+    }
+    if (!profile_path || !symbols_path){
+        fprintf(stderr, "usage: %s -p profile.txt -s symbols.txt [-b budget_bytes] [-n count]\n", argv[0]);
+        return 1;
+    }
+    if (read_profile(profile_path) || read_symbols(symbols_path)) return 1;
+    qsort(functions, num_functions, sizeof(Function), by_self_time);
+
+    printf("SRAM candidates by self time (budget %lu bytes)\n", budget);
+    printf("  %-32s %7s %12s %7s %10s\n", "function", "%time", "calls", "bytes", "total");
+    unsigned long total = 0;
+    double covered = 0;
+    for (int i = 0; i < num_functions && i < list_count; i++){
+        Function* f = &functions[i];
+        const char* verdict;
+        if (!f->size){
+            verdict = "no size";
+        } else if (total + f->size <= budget){
+            total += f->size;
+            covered += f->percent;
+            verdict = "fits";
+        } else {
+            verdict = "over budget";
+        }
+        printf("  %-32s %7.2f %12lu %7lu %10lu  %s\n", f->name, f->percent, f->calls, f->size, total, verdict);
+    }
+    printf("%lu bytes of code cover %.1f%% of the profiled time\n", total, covered);
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*
+Runs a rom headless and compares the cpu state before every instruction against a
+reference trace, stopping at the first divergence
+usage: tracediff [-r rom_id] [-s start_pc] [-S] [-C lines] reference.log
+    -r  run one of the test roms in rom_table.h instead of the rom built into rom.c
+    -s  start comparing once pc reaches start_pc (hex, default 0100)
+    -S  load the registers from the first reference line when comparing starts, for
+        references made with a different boot rom
+    -C  lines of context to print before a divergence (default 5)
+
+Both Gameboy-Doctor formats are understood, picked from the first line:
+    A: 01 F: B0 B: 00 C: 13 D: 00 E: D8 H: 01 L: 4D SP: FFFE PC: 00:0100 (00 C3 13 02)
+    A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02
+Gameboy-Doctor logs are made with LY reading as 0x90, which is why this tool is linked
+against a memory.c built with DEBUG_MODE_STUB_LY_0x90 (see the Makefile)
+*/
+#include "emulator.h"
+#include "trace.h"
+#include "rom_table.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+
+#define MAX_CONTEXT_LINES 64
+#define MAX_LINE_LENGTH 100
+
+typedef enum DoctorFormat {
+    DOCTOR_FORMAT_CLASSIC,   // debug_fmt_cpu_trace
+    DOCTOR_FORMAT_PCMEM
+} DoctorFormat;
+
+static Emulator emu;
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static void discard_serial(void* ctx, uint8_t data){
+}
+
+static inline char* put_hex8(char* p, uint8_t value){
+    p[0] = hex_digits[value >> 4];
+    p[1] = hex_digits[value & 0xF];
+    return p + 2;
+}
+
+static inline char* put_hex16(char* p, uint16_t value){
+    return put_hex8(put_hex8(p, value >> 8), value & 0xFF);
+}
+
+static inline char* put_label(char* p, const char* label, int length){
+    memcpy(p, label, length);
+    return p + length;
+}
+
+// Formats record without a line ending, returns its length
+// Hand rolled instead of sprintf, which would cap the tool at a few million lines a second
+static int format_line(char* line, const TraceRecord* record, DoctorFormat format){
+    static const char* const classic_labels[TRACE_REG_COUNT] = {"A: ", " F: ", " B: ", " C: ", " D: ", " E: ", " H: ", " L: "};
+    static const char* const pcmem_labels[TRACE_REG_COUNT] = {"A:", " F:", " B:", " C:", " D:", " E:", " H:", " L:"};
+    bool classic = format == DOCTOR_FORMAT_CLASSIC;
+    const char* const* labels = classic ? classic_labels : pcmem_labels;
+    char* p = line;
+    for (int i = 0; i < TRACE_REG_COUNT; i++){
+        p = put_label(p, labels[i], strlen(labels[i]));
+        p = put_hex8(p, record->regs[i]);
+    }
+    if (classic){
+        p = put_hex16(put_label(p, " SP: ", 5), record->sp);
+        p = put_hex16(put_label(p, " PC: 00:", 8), record->pc);
+        p = put_label(p, " (", 2);
+        for (int i = 0; i < 4; i++){
+            p = put_hex8(p, record->opcode_bytes[i]);
+            *p++ = i < 3 ? ' ' : ')';
+        }
+    } else {
+        p = put_hex16(put_label(p, " SP:", 4), record->sp);
+        p = put_hex16(put_label(p, " PC:", 4), record->pc);
+        p = put_label(p, " PCMEM:", 7);
+        for (int i = 0; i < 4; i++){
+            p = put_hex8(p, record->opcode_bytes[i]);
+            if (i < 3) *p++ = ',';
+        }
+    }
+    return p - line;
+}
+
+static bool load_registers(Registers* reg, const char* line, DoctorFormat format){
+    unsigned int a, f, b, c, d, e, h, l, sp, pc;
+    const char* fmt = format == DOCTOR_FORMAT_CLASSIC ?
+        "A: %x F: %x B: %x C: %x D: %x E: %x H: %x L: %x SP: %x PC: 00:%x" :
+        "A:%x F:%x B:%x C:%x D:%x E:%x H:%x L:%x SP:%x PC:%x";
+    if (sscanf(line, fmt, &a, &f, &b, &c, &d, &e, &h, &l, &sp, &pc) != 10){
+        return false;
+    }
+    reg->a = a; reg->f = f; reg->b = b; reg->c = c;
+    reg->d = d; reg->e = e; reg->h = h; reg->l = l;
+    reg->sp = sp;
+    reg->pc = pc;
+    return true;
+}
+
+// Name of the field our line's column falls in, for the divergence report
+static const char* field_at(const char* line, int column){
+    static char name[8];
+    if (column > 0 && memchr(line, '(', column)){
+        return "opcode bytes";
+    }
+    for (int i = column; i > 0; i--){
+        if (line[i] == ':' && line[i - 1] >= 'A' && line[i - 1] <= 'Z'){
+            int start = i - 1;
+            while (start > 0 && line[start - 1] >= 'A' && line[start - 1] <= 'Z') start--;
+            int length = i - start < 7 ? i - start : 7;
+            memcpy(name, line + start, length);
+            name[length] = '\0';
+            return name;
+        }
+    }
+    return "A";
+}
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv){
+    const uint8_t* cartridge = NULL;
+    uint16_t start_pc = 0x0100;
+    bool load_start_registers = false;
+    int context_lines = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:s:SC:")) != -1){
+        switch (opt){
+            case 'r':
+                cartridge = find_test_rom(atoi(optarg));
+                if (!cartridge){
+                    fprintf(stderr, "no test rom with id %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 's': start_pc = strtoul(optarg, NULL, 16); break;
+            case 'S': load_start_registers = true; break;
+            case 'C': context_lines = atoi(optarg); break;
+            default:
+                optind = argc + 1;
+                break;
+        }
+    }
+    if (optind != argc - 1){
+        fprintf(stderr, "usage: %s [-r rom_id] [-s start_pc] [-S] [-C lines] reference.log\n", argv[0]);
+        return 2;
+    }
+    if (context_lines < 0) context_lines = 0;
+    if (context_lines > MAX_CONTEXT_LINES) context_lines = MAX_CONTEXT_LINES;
+
+    const char* ref_path = argv[optind];
+    int fd = open(ref_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0){
+        perror(ref_path);
+        return 2;
+    }
+    if (st.st_size == 0){
+        fprintf(stderr, "%s is empty\n", ref_path);
+        return 2;
+    }
+    const char* ref = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ref == MAP_FAILED){
+        perror(ref_path);
+        return 2;
+    }
+    madvise((void*)ref, st.st_size, MADV_SEQUENTIAL);
+    const char* ref_end = ref + st.st_size;
+    DoctorFormat format = strncmp(ref, "A: ", 3) == 0 ? DOCTOR_FORMAT_CLASSIC : DOCTOR_FORMAT_PCMEM;
+
+    if (!setup_emulator(&emu, cartridge)){
+        fprintf(stderr, "the rom does not fit in EMULATOR_ARENA_SIZE\n");
+        return 1;
+    }
+    set_frame_sink(&emu.gpu, FRAME_SINK_NULL, NULL);
+    emu.mem.serial_hook = discard_serial;
+    while (emu.cpu.reg.pc < start_pc){
+        tick_emulator(&emu);
+    }
+    if (load_start_registers && !load_registers(&emu.cpu.reg, ref, format)){
+        fprintf(stderr, "can't read the registers from the first line of %s\n", ref_path);
+        return 2;
+    }
+
+    const char* history[MAX_CONTEXT_LINES];   // previous reference lines, all matched
+    TraceRecord record;
+    char line[MAX_LINE_LENGTH];
+    unsigned long compared = 0;
+    uint8_t last_cycles = 0;
+    double start = now_seconds();
+    const char* ref_line = ref;
+    while (ref_line < ref_end){
+        const char* newline = memchr(ref_line, '\n', ref_end - ref_line);
+        const char* next_line = newline ? newline + 1 : ref_end;
+        int ref_length = (newline ? newline : ref_end) - ref_line;
+        if (ref_length > 0 && ref_line[ref_length - 1] == '\r') ref_length--;
+        if (ref_length == 0){
+            ref_line = next_line;
+            continue;
+        }
+
+        trace_fill_record(&record, &emu.cpu, last_cycles);
+        int length = format_line(line, &record, format);
+        if (length != ref_length || memcmp(line, ref_line, length) != 0){
+            int column = 0;
+            while (column < length && column < ref_length && line[column] == ref_line[column]) column++;
+            printf("diverged after %lu matching instructions, %s differs (previous instruction took %d cycles)\n",
+                compared, field_at(line, column), last_cycles);
+            int shown = compared < (unsigned long)context_lines ? compared : context_lines;
+            for (int i = shown; i > 0; i--){
+                const char* context = history[(compared - i) % MAX_CONTEXT_LINES];
+                const char* context_end = memchr(context, '\n', ref_end - context);
+                int context_length = (context_end ? context_end : ref_end) - context;
+                if (context_length > 0 && context[context_length - 1] == '\r') context_length--;
+                printf("      %.*s\n", context_length, context);
+            }
+            printf("ref:  %.*s\n", ref_length, ref_line);
+            printf("got:  %.*s\n", length, line);
+            printf("      %*s^\n", column, "");
+            return 1;
+        }
+        history[compared % MAX_CONTEXT_LINES] = ref_line;
+        compared++;
+        ref_line = next_line;
+        last_cycles = tick_emulator(&emu);
+    }
+    double seconds = now_seconds() - start;
+    printf("all %lu instructions match\n", compared);
+    fprintf(stderr, "%.3fs, %.2f million instructions/s\n", seconds, compared / seconds / 1e6);
+    return 0;
+}
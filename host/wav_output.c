@@ -0,0 +1,55 @@
+#include "wav_output.h"
+#include "apu.h"
+
+#define WAV_HEADER_SIZE 44
+
+static void put_u16_le(uint8_t* out, uint16_t value){
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+static void put_u32_le(uint8_t* out, uint32_t value){
+    put_u16_le(out, value);
+    put_u16_le(&out[2], value >> 16);
+}
+
+static void write_header(FILE* f, uint32_t sample_count){
+    uint8_t header[WAV_HEADER_SIZE] = "RIFF....WAVEfmt ";
+    put_u32_le(&header[4], WAV_HEADER_SIZE - 8 + sample_count * 2);
+    put_u32_le(&header[16], 16);                     // fmt chunk size
+    put_u16_le(&header[20], 1);                      // PCM
+    put_u16_le(&header[22], 1);                      // mono
+    put_u32_le(&header[24], APU_SAMPLE_RATE);
+    put_u32_le(&header[28], APU_SAMPLE_RATE * 2);    // bytes per second
+    put_u16_le(&header[32], 2);                      // bytes per sample
+    put_u16_le(&header[34], 16);                     // bits per sample
+    header[36] = 'd'; header[37] = 'a'; header[38] = 't'; header[39] = 'a';
+    put_u32_le(&header[40], sample_count * 2);
+    fwrite(header, 1, WAV_HEADER_SIZE, f);
+}
+
+bool open_wav(WavOutput* wav, const char* path){
+    wav->f = fopen(path, "wb");
+    wav->sample_count = 0;
+    if (!wav->f) return false;
+    write_header(wav->f, 0);
+    return true;
+}
+
+void write_wav_samples(void* ctx, const int16_t* samples, int count){
+    WavOutput* wav = ctx;
+    int i;
+    for (i = 0; i < count; i++){
+        uint8_t bytes[2];
+        put_u16_le(bytes, samples[i]);
+        fwrite(bytes, 1, 2, wav->f);
+    }
+    wav->sample_count += count;
+}
+
+bool close_wav(WavOutput* wav){
+    bool ok = fseek(wav->f, 0, SEEK_SET) == 0;
+    if (ok) write_header(wav->f, wav->sample_count);
+    ok = !ferror(wav->f) && ok;
+    return fclose(wav->f) == 0 && ok;
+}
@@ -0,0 +1,21 @@
+/*
+Writes apu samples (APU_SINK_CALLBACK) into a mono 16 bit WAV file at APU_SAMPLE_RATE
+*/
+#ifndef WAV_OUTPUT_H
+#define WAV_OUTPUT_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdio.h"
+
+typedef struct WavOutput {
+    FILE* f;
+    uint32_t sample_count;
+} WavOutput;
+
+// Creates the file with a placeholder header; returns false if it could not be opened
+bool open_wav(WavOutput* wav, const char* path);
+// Apu write_samples callback, ctx is the WavOutput
+void write_wav_samples(void* ctx, const int16_t* samples, int count);
+// Fills in the header sizes and closes the file; returns false if anything could not be written
+bool close_wav(WavOutput* wav);
+#endif
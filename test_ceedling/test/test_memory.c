@@ -1,11 +1,16 @@
 #include "unity.h"
 #include "memory.h"
+#include "serial.h"
 #include "stdint.h"
+#include "string.h"
 #include "rom.h"
 
 
+static Memory mem;
+
 void setUp(void){
-	
+	// every test starts from all zeros: no OAM DMA holding the bus, sound off, nothing logged
+	memset(&mem, 0, sizeof(mem));
 }
 
 void tearDown(void){
@@ -13,7 +18,6 @@ void tearDown(void){
 }
 
 void test_consistent_access(void){
-	Memory mem; 
 	uint16_t addr;
 	uint8_t data1[5] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE};
 	write_mem(&mem, VRAM_END - 1 , 0xAA);
@@ -33,7 +37,6 @@ void test_consistent_access(void){
 }
 
 void test_clear_memory(void){
-	Memory mem; 
 	uint16_t addr;
 	uint8_t data1[5] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE};
 	
@@ -54,4 +57,110 @@ void test_clear_memory(void){
 	for (addr=WRAM_START;addr<WRAM_END;addr++){
 		TEST_ASSERT_EQUAL_HEX8(0x00, fetch(&mem, addr, false));
 	}
-}
\ No newline at end of file
+}
+
+void test_boot_rom_overlay(void){
+	uint8_t cartridge[ROM_END] = {0};
+	mem.rom = cartridge;
+	cartridge[0x0000] = 0x12;
+	cartridge[BIOS_SIZE] = 0x34;
+	
+	TEST_ASSERT_EQUAL_HEX8(bios[0x0000], fetch(&mem, 0x0000, true));
+	TEST_ASSERT_EQUAL_HEX8(0x12, fetch(&mem, 0x0000, false));
+	TEST_ASSERT_EQUAL_HEX8(0x34, fetch(&mem, BIOS_SIZE, true));
+	
+	write_mem(&mem, BOOT_LOC, 0x01);
+	TEST_ASSERT_EQUAL_HEX8(0x01, fetch(&mem, BOOT_LOC, false));
+}
+
+void test_tile_map_writes_counted(void){
+	mem.tile_map_writes = 0;
+	
+	write_mem(&mem, TILE_MAP_START - 1, 0x12);   // tile data
+	TEST_ASSERT_EQUAL_UINT32(0, mem.tile_map_writes);
+	write_mem(&mem, TILE_MAP_START, 0x12);
+	write_mem(&mem, VRAM_END - 1, 0x34);
+	TEST_ASSERT_EQUAL_UINT32(2, mem.tile_map_writes);
+}
+
+void test_sound_writes_logged_while_powered(void){
+	
+	write_mem(&mem, 0xFF12, 0xF0);                   // NR12 is dropped while the sound is off
+	TEST_ASSERT_EQUAL_UINT16(0, mem.sound_write_count);
+	write_mem(&mem, NR52_LOC, 0x80);
+	write_mem(&mem, 0xFF12, 0xF0);
+	write_mem(&mem, 0xFF14, 0x80);                   // trigger square 1
+	TEST_ASSERT_EQUAL_UINT16(3, mem.sound_write_count);
+	TEST_ASSERT_EQUAL_HEX8(0x14 - 0x10, mem.sound_writes[2].reg);
+	TEST_ASSERT_EQUAL_HEX8(0xF1, fetch(&mem, NR52_LOC, false));
+}
+
+void test_serial_transfer_queues_byte(void){
+	Serial serial;
+	setup_serial(&serial, &mem, SERIAL_OVERFLOW_DROP);
+	mem.serial_hook = NULL;
+	mem.interrupt_flag = 0;
+	uint8_t out;
+	
+	write_mem(&mem, SB_LOC, 'P');
+	write_mem(&mem, SC_LOC, 0x81);
+	TEST_ASSERT_EQUAL_INT(1, serial_ring_read(&serial.out, &out, 1));
+	TEST_ASSERT_EQUAL_HEX8('P', out);
+	tick_serial(&serial, SERIAL_TRANSFER_CYCLES - 1);
+	TEST_ASSERT_EQUAL_HEX8(0x81, mem.sc);
+	tick_serial(&serial, 4);
+	TEST_ASSERT_EQUAL_HEX8(0x01, mem.sc);
+	TEST_ASSERT_EQUAL_HEX8(INTERRUPT_ENABLE_SERIAL_MASK, mem.interrupt_flag);
+}
+
+void test_eram_sized_from_cart_header(void){
+	uint8_t cart[0x150];
+	uint8_t eram[0x800];
+	memset(cart, 0, sizeof(cart));
+	TEST_ASSERT_EQUAL_UINT16(0, cart_ram_size(cart));
+	cart[CART_RAM_SIZE_LOC] = 0x03;                  // 32KB, one bank of it mapped
+	TEST_ASSERT_EQUAL_UINT16(EXTERNAL_RAM_SIZE, cart_ram_size(cart));
+	cart[CART_RAM_SIZE_LOC] = 0x01;
+	mem.eram = eram;
+	mem.eram_size = cart_ram_size(cart);
+	
+	write_mem(&mem, EXTERNAL_RAM_START + 0x7FF, 0x5A);
+	TEST_ASSERT_EQUAL_HEX8(0x5A, fetch(&mem, EXTERNAL_RAM_START + 0x7FF, false));
+	write_mem(&mem, EXTERNAL_RAM_START + 0x800, 0x5A);   // past the cart's ram: dropped, reads 0xFF
+	TEST_ASSERT_EQUAL_HEX8(0xFF, fetch(&mem, EXTERNAL_RAM_START + 0x800, false));
+}
+
+void test_high_page_through_io_and_switch(void){
+	write_high(&mem, (uint8_t) SCX_LOC, 0x23);
+	TEST_ASSERT_EQUAL_HEX8(0x23, mem.scroll_x);
+	TEST_ASSERT_EQUAL_HEX8(0x23, mem.io[SCX_LOC - IO_START]);
+	TEST_ASSERT_EQUAL_HEX8(0x23, fetch_high(&mem, (uint8_t) SCX_LOC));
+	TEST_ASSERT_FALSE(mem.stop_batch);
+	
+	write_high(&mem, (uint8_t) TIMER_DIV_LOC, 0x55);   // still resets DIV and ends the batch
+	TEST_ASSERT_EQUAL_HEX8(0, fetch_high(&mem, (uint8_t) TIMER_DIV_LOC));
+	TEST_ASSERT_TRUE(mem.stop_batch);
+	
+	write_high(&mem, 0x80, 0x77);
+	TEST_ASSERT_EQUAL_HEX8(0x77, mem.zero_page[0]);
+	write_high(&mem, 0xFF, 0x1F);
+	TEST_ASSERT_EQUAL_HEX8(0x1F, mem.interrupt_enable);
+	TEST_ASSERT_EQUAL_HEX8(0, fetch_high(&mem, 0x4D));    // unmapped
+}
+
+void test_oam_dma_copies_and_locks_bus(void){
+	mem.wram[0x100] = 0x12;
+	mem.wram[0x19F] = 0x34;
+	
+	write_mem(&mem, OAM_DMA_LOC, 0xC1);
+	TEST_ASSERT_EQUAL_HEX8(0x12, mem.oam[0]);
+	TEST_ASSERT_EQUAL_HEX8(0x34, mem.oam[OAM_SIZE - 1]);
+	// only HRAM and the I/O registers until the lock runs out
+	TEST_ASSERT_EQUAL_HEX8(0xFF, fetch(&mem, 0xC100, false));
+	write_mem(&mem, ZERO_PAGE_START, 0x56);
+	TEST_ASSERT_EQUAL_HEX8(0x56, fetch(&mem, ZERO_PAGE_START, false));
+	tick_dma(&mem, OAM_DMA_CYCLES - 1);
+	TEST_ASSERT_EQUAL_HEX8(0xFF, fetch_ram(&mem, 0xC100, false));
+	tick_dma(&mem, 4);
+	TEST_ASSERT_EQUAL_HEX8(0x12, fetch_ram(&mem, 0xC100, false));
+}
@@ -0,0 +1,49 @@
+#include "unity.h"
+#include "timer.h"
+#include "memory.h"
+#include "serial.h"
+#include "rom.h"
+#include "string.h"
+
+
+void setUp(void){
+	
+}
+
+void tearDown(void){
+
+}
+
+static void run_timer(Timer* timer, long machine_cycles){
+	while (machine_cycles > 0){
+		uint8_t step = machine_cycles > 200 ? 200 : machine_cycles;
+		tick_timer(timer, step);
+		machine_cycles -= step;
+	}
+}
+
+void test_tima_stays_put_after_fast_boot(void){
+	Memory mem;
+	Timer timer;
+	memset(&mem, 0, sizeof(mem));
+	memset(&timer, 0, sizeof(timer));
+	setup_timer(&timer, &mem);
+	mem.timer_control = 0xF8;                  // what skip_boot_rom leaves: bits 3-7 set, enable (bit 2) clear
+	
+	run_timer(&timer, 100000);
+	TEST_ASSERT_EQUAL_HEX8(0x00, mem.timer_counter);
+	TEST_ASSERT_EQUAL_HEX8(0x00, mem.interrupt_flag);
+	TEST_ASSERT_TRUE(mem.timer_divider != 0);   // DIV always counts
+}
+
+void test_tima_counts_when_enabled(void){
+	Memory mem;
+	Timer timer;
+	memset(&mem, 0, sizeof(mem));
+	memset(&timer, 0, sizeof(timer));
+	setup_timer(&timer, &mem);
+	mem.timer_control = TIMER_CONTROL_ENABLE_MASK | 0x01;   // every 4 machine cycles
+	
+	run_timer(&timer, 4 * 0x10);
+	TEST_ASSERT_EQUAL_HEX8(0x10, mem.timer_counter);
+}